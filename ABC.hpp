@@ -1,13 +1,15 @@
 #pragma once
 #include "library.hpp"
+#include "construction.hpp"
 
 struct bee {
     vector<int> path;
-    double cost;
+    COST cost;
     int cycle;
     char role;
+    philox rng;
 
-    bee(vector<int> initial_path, double initial_cost) 
+    bee(vector<int> initial_path, COST initial_cost) 
     {
         /*
             Objective:
@@ -18,10 +20,12 @@ struct bee {
         */
         path = initial_path;
         cost = initial_cost;
+        cycle = 0;
     }
 };
 
 class ABC {
+    context& ctx;
     int n_cities;
     int cycles_limit;
     int employed_limit;
@@ -29,28 +33,35 @@ class ABC {
     double scout_percent;
     double onlooker_percent;
     double employed_percent;
+    LD selection_pressure;
+    vector<int> sources;
+    vector<LD> quality;
+    vector<int> visits;
+    alias_table roulette;
 
 public:
     vector<int> best_solution;
-    LD best_cost;
+    COST best_cost;
 
-    ABC(vector<int> initial_solution, LD initial_cost) 
+    ABC(context& instance, vector<int> initial_solution, COST initial_cost) : ctx(instance)
     {
         /*
             Objective:
                 Constructor for the ABC class.
             Parameters:
+                - instance: Context of the solve.
                 - initial_solution: Initial solution of the ABC algorithm.
                 - initial_cost: Initial cost of the solution.
         */
 
-        n_cities = utilities::n_cities;
-        cycles_limit = utilities::param.abc_p.cycles_limit;
-        employed_limit = utilities::param.abc_p.employed_limit;
-        colony_size = utilities::param.abc_p.colony_size;
-        scout_percent = utilities::param.abc_p.scout_percent;
-        onlooker_percent = utilities::param.abc_p.onlooker_percent;
-        employed_percent = utilities::param.abc_p.employed_percent;
+        n_cities = ctx.n_cities;
+        cycles_limit = ctx.param.abc_p.cycles_limit;
+        employed_limit = ctx.param.abc_p.employed_limit;
+        colony_size = ctx.param.abc_p.colony_size;
+        scout_percent = ctx.param.abc_p.scout_percent;
+        onlooker_percent = ctx.param.abc_p.onlooker_percent;
+        employed_percent = ctx.param.abc_p.employed_percent;
+        selection_pressure = ctx.param.abc_p.selection_pressure;
         best_solution = initial_solution;
         best_cost = initial_cost;
     }
@@ -87,20 +98,77 @@ public:
             hive[i].role = 'O';
         }
 
+        // The first forager keeps the initial solution, so the onlookers have a good food source from the start.
         for (int i = onlooker_count; i < colony_size; ++i) 
         {
-            random_shuffle(hive[i].path.begin(),hive[i].path.end());
+            if (i > onlooker_count)
+                shuffle(hive[i].path.begin(), hive[i].path.end(), utilities::rng());
+            hive[i].cost = utilities::Fx_fit(hive[i].path, n_cities);
             hive[i].role = 'E';
         }
     }
 
-    vector<int> update_path(const vector<int> path)
+    bool update_path(vector<int> &path, COST &cost, philox &rng)
     {
-        vector<int> new_path = path;
-        int random_idx = utilities::random_range(0, path.size() - 1);
-        swap(new_path[random_idx], new_path[random_idx + 1]);
-        
-        return new_path;
+        /*
+            Objective:
+                Tries one random neighborhood move (adjacent swap, 2-opt or Or-opt) on the path in place.
+                The move is scored by its delta cost and applied only when it improves the path.
+            Parameters:
+                - path: Reference to the path to be improved.
+                - cost: Reference to the cost of the path, updated when the move is applied.
+                - rng: Generator of the calling bee or worker.
+            Returns:
+                True if the path was improved.
+        */
+
+        int n = path.size();
+        if (n < 5)
+            return false;
+
+        int move = utilities::random_range(rng, 0, 3);
+        COST delta;
+
+        if (move == 0)
+        {
+            int i = utilities::random_range(rng, 0, n);
+            delta = utilities::swap_delta(path, i);
+
+            if (delta >= 0)
+                return false;
+
+            swap(path[i], path[(i + 1) % n]);
+        }
+        else if (move == 1)
+        {
+            int i = utilities::random_range(rng, 0, n - 2);
+            int j = utilities::random_range(rng, i + 2, n);
+            delta = utilities::two_opt_delta(path, i, j);
+
+            if (delta >= 0)
+                return false;
+
+            utilities::apply_two_opt(path, i, j);
+        }
+        else
+        {
+            int len = utilities::random_range(rng, 1, 4);
+            int i = utilities::random_range(rng, 0, n - len + 1);
+            int j = utilities::random_range(rng, 0, n);
+
+            if ((j >= i - 1 && j <= i + len - 1) || (i == 0 && j == n - 1))
+                return false;
+
+            delta = utilities::or_opt_delta(path, i, len, j);
+
+            if (delta >= 0)
+                return false;
+
+            utilities::apply_or_opt(path, i, len, j);
+        }
+
+        cost += delta;
+        return true;
     }
 
     void employed(bee &bee) 
@@ -112,13 +180,8 @@ public:
                 - bee: Reference to the bee.
         */
 
-        vector<int> new_path = update_path(bee.path);
-        double new_cost = utilities::Fx_fit(new_path, n_cities);
-
-        if (new_cost < bee.cost) 
+        if (update_path(bee.path, bee.cost, bee.rng)) 
         {
-            bee.path = new_path;
-            bee.cost = new_cost;
             bee.cycle = 0; // reset cycle so bee can continue to make progress
         } 
         else 
@@ -136,12 +199,16 @@ public:
     {
         /*
             Objective:
-                Implements the scout bee phase.
+                Implements the scout bee phase: the abandoned source is replaced by a nearest neighbor tour from a
+                random start city (a random tour when the construction heuristic is "identity").
             Parameters:
                 - bee_s: Reference to the scout bee.
         */
 
-        random_shuffle(bee_s.path.begin(), bee_s.path.end());
+        if (ctx.param.init == "identity")
+            shuffle(bee_s.path.begin(), bee_s.path.end(), bee_s.rng);
+        else
+            bee_s.path = construction::nearest_neighbor(utilities::random_range(bee_s.rng, 0, n_cities));
         bee_s.cost = utilities::Fx_fit(bee_s.path, n_cities);
         bee_s.role = 'E';
         bee_s.cycle = 0;
@@ -152,46 +219,100 @@ public:
         /*
             Objective:
                 Implements the onlooker bee phase.
+                Each onlooker draws a food source (an employed bee) from an alias table built from the bee costs,
+                then exploits it with a delta-evaluated move. Draws are made in order from the ABC stream;
+                the sources are then exploited in parallel, each one by its own bee, so a seed reproduces the run.
             Parameters:
                 - hive: Reference to the vector representing the hive.
         */
 
-        for (auto &bee : hive) 
+        int onlookers = 0;
+        COST best = INF;
+
+        sources.clear();
+        quality.clear();
+
+        for (int i = 0; i < (int)hive.size(); ++i)
         {
-            if (bee.role == 'O') 
+            if (hive[i].role == 'O')
             {
-                vector<int> new_path = update_path(best_solution);
+                onlookers++;
+            }
+            else if (hive[i].role == 'E')
+            {
+                sources.push_back(i);
+                best = min(best, hive[i].cost);
+            }
+        }
 
-                double new_cost = utilities::Fx_fit(new_path, n_cities);
+        int m = sources.size();
+        if (!m || !onlookers)
+            return;
 
-                if (new_cost < best_cost)
-                {
-                    best_cost = new_cost;
-                    best_solution = new_path;
-                }
+        // Quality of a source is (best / cost)^pressure, so near-best sources get most of the onlookers.
+        for (auto i : sources)
+            quality.push_back(pow((LD)best / hive[i].cost, selection_pressure));
+
+        roulette.build(quality);
+        visits.assign(m, 0);
+
+        for (int k = 0; k < onlookers; k++)
+            visits[roulette.sample(utilities::rng())]++;
+
+        utilities::pool().parallel_for(m, [&](int s)
+        {
+            bee &source = hive[sources[s]];
+
+            for (int k = 0; k < visits[s]; k++)
+                if (update_path(source.path, source.cost, source.rng))
+                    source.cycle = 0;
+        });
+
+        for (auto i : sources)
+        {
+            if (hive[i].cost < best_cost)
+            {
+                best_cost = hive[i].cost;
+                best_solution = hive[i].path;
             }
         }
     }
 
-    void bees_for_pollen(vector<bee> &hive, int scout_count)
+    void bees_for_pollen(vector<bee> &hive, int scout_count, int cycle)
      {
         /*
             Objective:
                 Sends bees for pollen collection and updates their roles.
+                Employed and scout bees only touch their own bee, so they run in parallel; each bee draws from the
+                stream keyed by (seed, cycle, bee) and the global best is reduced afterwards in index order.
             Parameters:
                 - hive: Reference to the vector representing the hive.
                 - scout_count: Number of scout bees.
+                - cycle: Current cycle.
         */
 
-        vector<pair<int, LD>> results;
+        vector<pair<int, COST>> results;
         int m = hive.size();
+        vector<char> phase(m);
 
         for (int i = 0; i < m; ++i)
         {
-            if (hive[i].role == 'E')
-            {
+            phase[i] = hive[i].role;
+            hive[i].rng.reset(ctx.param.seed, RNG_ABC, cycle, i);
+        }
+
+        utilities::pool().parallel_for(m, [&](int i)
+        {
+            if (phase[i] == 'E')
                 employed(hive[i]);
+            else if (phase[i] == 'S')
+                scouter_bee(hive[i]);
+        });
 
+        for (int i = 0; i < m; ++i)
+        {
+            if (phase[i] == 'E')
+            {
                 if (hive[i].cost < best_cost) 
                 {
                     best_cost = hive[i].cost;
@@ -199,24 +320,55 @@ public:
                 }
                 results.push_back({i, hive[i].cost});
             }
-            else if (hive[i].role == 'S')
-            {
-                scouter_bee(hive[i]);
-            }
         }
 
-        sort(results.begin(), results.end(), [](const auto &lb, const auto &rb)
+        stable_sort(results.begin(), results.end(), [](const auto &lb, const auto &rb)
              { return lb.second > rb.second; });
 
         m = results.size();
 
-        for (int j = 0; j < scout_count && j < m; ++j) 
+        // The richest food source is never abandoned, onlookers keep exploiting it.
+        for (int j = 0; j < scout_count && j < m - 1; ++j) 
         {
             hive[results[j].first].role = 'S';
         }
     }
 
-    LD solution() 
+    void restart(vector<bee> &hive, const int& cycle)
+    {
+        /*
+            Objective:
+                Restart a stagnated hive from the elite: every food source becomes the best solution perturbed by a
+                double-bridge kick, except one that keeps the best solution itself.
+            Parameters:
+                - hive: Reference to the vector representing the hive.
+                - cycle: Current cycle.
+        */
+
+        bool kept = false;
+
+        for (int i = 0; i < (int)hive.size(); i++)
+        {
+            if (hive[i].role != 'E')
+                continue;
+
+            hive[i].path = best_solution;
+            hive[i].cost = best_cost;
+            hive[i].cycle = 0;
+
+            if (!kept)
+            {
+                kept = true;
+                continue;
+            }
+
+            hive[i].rng.reset(ctx.param.seed, RNG_ABC, cycle, hive.size() + i);
+            utilities::double_bridge(hive[i].path, hive[i].rng);
+            hive[i].cost = utilities::Fx_fit(hive[i].path, n_cities);
+        }
+    }
+
+    COST solution() 
     {
         /*
             Objective:
@@ -224,18 +376,48 @@ public:
             Returns:
                 Best cost found by the algorithm.
         */
+        context_scope scope(ctx);
+        rng_scope stream(RNG_ABC);
         vector<bee> hive;
         int scout_count = colony_size * scout_percent;
         initialize_hive(hive);
         clt(hive);
+        convergence_monitor monitor;
 
-        for (int i = 0; i < cycles_limit; i++)
+        for (int i = 0; i < cycles_limit && !utilities::should_stop(best_cost); i++)
         {
-            bees_for_pollen(hive, scout_count);
+            bees_for_pollen(hive, scout_count, i);
             outlooker_bee(hive);
 
+            // Portfolio checkpoint: a better incumbent replaces the worst food source.
+            if (utilities::share(best_solution, best_cost))
+            {
+                int worst = -1;
+                for (int j = 0; j < (int)hive.size(); j++)
+                    if (hive[j].role == 'E' && (worst == -1 || hive[j].cost > hive[worst].cost))
+                        worst = j;
+
+                if (worst != -1)
+                {
+                    hive[worst].path = best_solution;
+                    hive[worst].cost = best_cost;
+                    hive[worst].cycle = 0;
+                }
+            }
+
+            monitor_action action = monitor.observe(best_cost);
+            if (action == MONITOR_STOP)
+                break;
+            if (action == MONITOR_RESTART)
+                restart(hive, i);
+
         }
 
+        // Every food source is offered to the elite pool, not only the best.
+        for (auto& source : hive)
+            ctx.elites.offer(source.path, source.cost);
+        ctx.elites.offer(best_solution, best_cost);
+
         return best_cost;
     }
 };
\ No newline at end of file
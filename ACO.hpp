@@ -1,5 +1,64 @@
 #pragma once
 #include "library.hpp"
+#include "construction.hpp"
+
+#define TRAIL_FLOOR 1e-6
+
+struct ant
+{
+    /*
+        Objective:
+            Reusable scratch space of one ant, allocated once and kept across generations.
+
+        Attributes:
+            tour: Tour being built by the ant.
+            visited: Bitmap of the cities already in the tour.
+            weight: Choice value of each city for the current step (0 for visited cities).
+            unvisited, where: Cities not yet in the tour and the position of every city in that list.
+            fit: Fitness value of the tour.
+            rng: Counter-based generator of the ant, keyed by (seed, generation, ant) before every generation.
+    */
+
+    vector<int> tour;
+    vector<char> visited;
+    vector<LD> weight;
+    vector<int> unvisited, where;
+    COST fit;
+    philox rng;
+
+    ant(int n)
+    {
+        tour.assign(n, -1);
+        visited.assign(n, 0);
+        weight.assign(n, 0);
+        unvisited.assign(n, 0);
+        where.assign(n, 0);
+        fit = INF;
+    }
+
+    void reset()
+    {
+        int n = tour.size();
+        fill(visited.begin(), visited.end(), 0);
+        unvisited.resize(n);
+        for (int i = 0; i < n; i++)
+            unvisited[i] = where[i] = i;
+    }
+
+    void visit(const int& city)
+    {
+        /*
+            Objective:
+                Mark a city as visited, removing it from the unvisited list in O(1).
+        */
+
+        visited[city] = 1;
+        int last = unvisited.back();
+        unvisited[where[city]] = last;
+        where[last] = where[city];
+        unvisited.pop_back();
+    }
+};
 
 class ACO
 {
@@ -9,17 +68,34 @@ class ACO
             This class provides methods for initializing maps, performing ant colony simulation, and obtaining the best path and fitness value.
 
         Attributes:
+            ctx: Context of the solve.
             best_path: The best path found by the ACO algorithm.
-            attr: Map storing the attractiveness between cities.
-            trail_phero: Map storing the pheromone trail between cities.
+            attr: Attractiveness of every edge: flat nodes x nodes matrix, or one value per candidate edge aligned with
+                neighbors in candidate mode.
+            trail_phero: Pheromone trail of every edge, with the same layout as attr. In candidate mode only candidate
+                edges carry pheromone, so evaporation and deposits cost O(nodes * candidates).
+            choice: Flat nodes x nodes matrix with pheromone^alpha * attractiveness^beta, refreshed once per generation.
+            candidates: Number of candidate cities per city considered by the ants (alpha-nearest when the lower bound computed them, nearest otherwise; 0 when disabled).
+            neighbors: Flat nodes x candidates list of the nearest neighbors of each city.
+            cand_choice: Choice value of each candidate edge, aligned with neighbors.
+            colony: Ants of the colony, each one with its own reusable scratch buffers.
+            tau_min, tau_max: MMAS pheromone bounds.
+            stagnant: MMAS generations since the global best last improved.
             nodes: Number of cities.
             best_fit: The fitness value of the best path found.
     */
 
+    context& ctx;
     vector<int> best_path;
-    unormap<pair<int,int>, LD, hash_pair> attr, trail_phero;
+    vector<LD> attr, trail_phero, choice;
+    vector<ant> colony;
+    int candidates;
+    vector<int> neighbors;
+    vector<LD> cand_choice;
+    LD tau_min, tau_max;
+    int stagnant;
     int nodes;
-    LD best_fit;
+    COST best_fit;
     
     void local_search_2_opt()
     {
@@ -30,121 +106,364 @@ class ACO
 
         */
 
-        for (int it = 1; it <= utilities::param.aco_p.max_opt_it; it++)
+        for (int it = 1; it <= ctx.param.aco_p.max_opt_it; it++)
             utilities::opt_2(best_path, best_fit);
     }
 
-    int city_selection(const vector<vector<LD>>& prob, const set<int>& contain)
+    int city_selection(ant& worker, const int& city)
     {
         /*
             Objective:
-                Select a city based on probability for the ant's movement.
+                Select the next city of the ant with a single roulette over the precomputed choice values.
 
             Parameters:
-                - prob: Probability matrix indicating the likelihood of selecting each city.
-                - contain: Set of cities already visited by the ant.
+                - worker: Ant whose scratch buffer receives the weights of the unvisited cities.
+                - city: Index of the current city.
 
             Returns:
                 The index of the selected city.
         */
 
-        LD cut = utilities::random_range_double(0, 1);
+        const LD* row = &choice[city * nodes];
+        LD sum = 0;
 
         for (int i = 0; i < nodes; i++)
-            if (cut <= prob[i][2] && !contain.count(i))
+        {
+            worker.weight[i] = (worker.visited[i] ? 0 : row[i]);
+            sum += worker.weight[i];
+        }
+
+        LD cut = worker.rng.real() * sum;
+        int last = -1;
+
+        for (int i = 0; i < nodes; i++)
+        {
+            if (worker.visited[i])
+                continue;
+
+            last = i;
+            cut -= worker.weight[i];
+
+            if (cut <= 0)
                 return i;
+        }
 
-        return -1;
+        return last;
     }
 
-    vector<vector<LD>> city_probability(const int& city, const set<int>& contain)
+    int candidate_selection(ant& worker, const int& city)
     {
         /*
             Objective:
-                Calculate the probability of selecting each city based on attractiveness and pheromone trails.
+                Select the next city of the ant among the nearest unvisited neighbors of the current city.
+                When every candidate was already visited, fall back to the nearest unvisited city.
 
             Parameters:
+                - worker: Ant whose scratch buffer receives the weights of the candidates.
                 - city: Index of the current city.
-                - contain: Set of cities already visited by the ant.
 
             Returns:
-                Probability matrix indicating the likelihood of selecting each city.
+                The index of the selected city.
         */
 
+        const int* near = &neighbors[city * candidates];
+        const LD* row = &cand_choice[city * candidates];
         LD sum = 0;
-        vector<vector<LD>> probability(nodes, vector<LD>(3, 0));
 
-        for (int i = 0; i < nodes; i++)
-            if (!contain.count(i))
-                probability[i][0] = pow(attr[{i, city}], utilities::param.aco_p.alpha) * pow(attr[{i, city}], utilities::param.aco_p.beta);
+        for (int i = 0; i < candidates; i++)
+        {
+            worker.weight[i] = (worker.visited[near[i]] ? 0 : row[i]);
+            sum += worker.weight[i];
+        }
 
-        for (int i = 0; i < nodes; i++)
-            sum += probability[i][0];
+        if (sum > 0)
+        {
+            LD cut = worker.rng.real() * sum;
+            int last = -1;
 
-        for (int i = 0; i < nodes; i++)
+            for (int i = 0; i < candidates; i++)
+            {
+                if (worker.weight[i] == 0)
+                    continue;
+
+                last = near[i];
+                cut -= worker.weight[i];
+
+                if (cut <= 0)
+                    return near[i];
+            }
+
+            return last;
+        }
+
+        // Every candidate is taken: go to the nearest unvisited city.
+        int best = -1;
+        COST best_dist = INF;
+
+        for (int i : worker.unvisited)
         {
-            if (!contain.count(i) && sum != 0)
-                probability[i][1] = probability[i][0] / sum;
+            COST dist = utilities::distance(city, i);
+            if (dist < best_dist || (dist == best_dist && i < best))
+                best = i, best_dist = dist;
+        }
+
+        return best;
+    }
+
+    LD edge_choice(const int& edge)
+    {
+        /*
+            Objective:
+                Compute pheromone^alpha * attractiveness^beta for one edge of the trail and attractiveness stores.
+        */
 
-            if (i == 0)
-                probability[i][2] = probability[i][1]; 
-            else
-                probability[i][2] = probability[i][1] + probability[i - 1][2];
+        return pow(max(trail_phero[edge], (LD)TRAIL_FLOOR), ctx.param.aco_p.alpha) * pow(attr[edge], ctx.param.aco_p.beta);
+    }
+
+    void update_choice()
+    {
+        /*
+            Objective:
+                Precompute the choice value of every edge (or only of the candidate edges), once per generation.
+        */
+
+        if (candidates)
+        {
+            for (int i = 0; i < nodes; i++)
+                for (int j = 0; j < candidates; j++)
+                    cand_choice[i * candidates + j] = edge_choice(i * candidates + j);
+            return;
         }
 
-        for (auto e : contain)
-            probability[e][2] = 0;   
-                      
-        return probability;
+        for (int i = 0; i < nodes * nodes; i++)
+            choice[i] = edge_choice(i);
     }
     
+    void deposit(const int& a, const int& b, const LD& amount)
+    {
+        /*
+            Objective:
+                Add pheromone to the edge (a, b) in both directions. In candidate mode a direction is stored only when
+                the other city is a candidate of its origin.
+        */
+
+        if (!candidates)
+        {
+            trail_phero[a * nodes + b] += amount;
+            trail_phero[b * nodes + a] += amount;
+            return;
+        }
+
+        for (int t = 0; t < candidates; t++)
+        {
+            if (neighbors[a * candidates + t] == b)
+                trail_phero[a * candidates + t] += amount;
+            if (neighbors[b * candidates + t] == a)
+                trail_phero[b * candidates + t] += amount;
+        }
+    }
+
     void update_trail()
     {
         /*
             Objective:
                 Update the pheromone trail after each iteration of ant movement.
         */
-        for (int i = 0; i < nodes; i++) 
-            trail_phero[{best_path[i], best_path[i + 1]}]++;
+        for (int i = 0; i < nodes; i++)
+            deposit(best_path[i], best_path[(i + 1) % nodes], 1);
     }
 
-    void ants_for_sugar()
+    void update_bounds()
     {
         /*
             Objective:
-                Simulate ant movement to find an optimal path for the TSP.
+                Recompute the MMAS pheromone bounds from the global best fitness.
         */
 
-        vector<int> city_list(nodes);
-        for (int i = 0; i < utilities::param.aco_p.ants; i++)
+        LD rho = ctx.param.aco_p.decay;
+        LD p_dec = pow(ctx.param.aco_p.p_best, 1.0 / nodes);
+
+        tau_max = 1.0 / (rho * (LD)best_fit);
+        tau_min = tau_max * (1 - p_dec) / ((nodes / 2.0 - 1) * p_dec);
+        tau_min = min(tau_min, tau_max);
+    }
+
+    void mmas_trail(const vector<int>& tour, const COST& fit)
+    {
+        /*
+            Objective:
+                MMAS pheromone update: proportional evaporation of every edge, deposit of 1/fit on the
+                edges of the chosen tour, and clamping of the whole matrix to [tau_min, tau_max].
+
+            Parameters:
+                - tour: Tour that deposits pheromone (iteration best or global best).
+                - fit: Fitness value of the tour.
+        */
+
+        LD keep = 1 - ctx.param.aco_p.decay;
+        LD amount = 1.0 / (LD)fit;
+        int m = trail_phero.size();
+
+        for (int i = 0; i < m; i++)
+            trail_phero[i] *= keep;
+
+        for (int i = 0; i < nodes; i++)
+            deposit(tour[i], tour[(i + 1) % nodes], amount);
+
+        for (int i = 0; i < m; i++)
+            trail_phero[i] = min(max(trail_phero[i], tau_min), tau_max);
+    }
+
+    void restart_trails(const int& it)
+    {
+        /*
+            Objective:
+                Restart a stagnated colony: the trails go back to their initial value and the best tour, perturbed by a
+                double-bridge kick, deposits once so the search resumes around the elite.
+
+            Parameters:
+                - it: Current generation.
+        */
+
+        philox kick = utilities::stream(RNG_ACO, it, colony.size());
+        vector<int> tour = best_path;
+        utilities::double_bridge(tour, kick);
+        COST fit = utilities::Fx_fit(tour, nodes);
+
+        if (ctx.param.aco_p.mmas)
         {
-            set<int> contain;
-            city_list[0] = (utilities::param.aco_p.fix_init == -1 ? utilities::random_range(0, nodes) : utilities::param.aco_p.fix_init);
-            contain.insert(city_list[0]);
+            update_bounds();
+            fill(trail_phero.begin(), trail_phero.end(), tau_max);
+            mmas_trail(tour, fit);
+            stagnant = 0;
+            return;
+        }
 
-            for (int j = 1; j < nodes; j++)
+        // Classic trails deposit one unit per edge (update_trail), so the elite deposits on that scale too.
+        fill(trail_phero.begin(), trail_phero.end(), 1.0);
+        for (int i = 0; i < nodes; i++)
+            deposit(tour[i], tour[(i + 1) % nodes], 1);
+    }
+
+    void seed_trails()
+    {
+        /*
+            Objective:
+                Initialize the trails on the edges of the elite pool, so the colony starts around the tours the previous
+                stages found instead of from uniform trails. MMAS: every elite deposits once, most expensive first, so
+                the edges of the better tours keep the most pheromone; classic: every elite edge gets one deposit.
+        */
+
+        vector<pair<COST, vector<int>>> elites = ctx.elites.tours();
+
+        for (int e = (int)elites.size() - 1; e >= 0; e--)
+        {
+            const vector<int>& tour = elites[e].second;
+
+            if (ctx.param.aco_p.mmas)
             {
-                vector<vector<LD>> probability = city_probability(j, contain);
-                int path_point = city_selection(probability, contain);
-                
-                if (path_point == -1)
-                    for (int l = 0; l < nodes && path_point == -1; l++)
-                        if (!contain.count(l))
-                            path_point = l;
-
-                city_list[j] = path_point;
-                contain.insert(path_point);
+                mmas_trail(tour, elites[e].first);
+                continue;
             }
-            
-            LD new_fit = utilities::Fx_fit(city_list, nodes);
-            if (new_fit < best_fit)
-                best_path = city_list, best_fit = new_fit;
+
+            for (int i = 0; i < nodes; i++)
+                deposit(tour[i], tour[(i + 1) % nodes], 1);
         }
-        
-        if (utilities::param.aco_p.local_search)
+    }
+
+    void build_tour(ant& worker)
+    {
+        /*
+            Objective:
+                Build a complete tour for one ant, reusing its scratch buffers.
+
+            Parameters:
+                - worker: Ant that builds the tour.
+        */
+
+        worker.reset();
+        worker.tour[0] = (ctx.param.aco_p.fix_init == -1 ? worker.rng.bounded(nodes) : ctx.param.aco_p.fix_init);
+        worker.visit(worker.tour[0]);
+
+        for (int j = 1; j < nodes; j++)
+        {
+            int path_point = (candidates ? candidate_selection(worker, worker.tour[j - 1]) : city_selection(worker, worker.tour[j - 1]));
+
+            worker.tour[j] = path_point;
+            worker.visit(path_point);
+        }
+
+        worker.fit = utilities::Fx_fit(worker.tour, nodes);
+    }
+
+    void ants_for_sugar(const int& it)
+    {
+        /*
+            Objective:
+                Simulate ant movement to find an optimal path for the TSP.
+                Ants only read the choice matrix while building their tours, so they run in parallel on the shared pool.
+                Each ant draws from the stream keyed by (seed, generation, ant), so the tours do not depend on the thread schedule.
+
+            Parameters:
+                - it: Current generation.
+        */
+
+        update_choice();
+
+        for (int i = 0; i < (int)colony.size(); i++)
+            colony[i].rng.reset(ctx.param.seed, RNG_ACO, it, i);
+
+        utilities::pool().parallel_for(colony.size(), [&](int i) { build_tour(colony[i]); });
+    }
+
+    void reduce_generation(const int& it)
+    {
+        /*
+            Objective:
+                Reduction step between generations: keep the best tour of the colony (lowest index on ties),
+                then apply the local search and the pheromone update of the active model.
+
+            Parameters:
+                - it: Current generation.
+        */
+
+        int best_ant = 0;
+        int m = colony.size();
+
+        for (int i = 1; i < m; i++)
+            if (colony[i].fit < colony[best_ant].fit)
+                best_ant = i;
+
+        bool improved = colony[best_ant].fit < best_fit;
+        if (improved)
+            best_path = colony[best_ant].tour, best_fit = colony[best_ant].fit;
+
+        if (ctx.param.aco_p.local_search)
             local_search_2_opt();
 
-        update_trail();
+        if (!ctx.param.aco_p.mmas)
+        {
+            update_trail();
+
+            for (auto& e : trail_phero)
+                e = max(e - ctx.param.aco_p.decay, (LD)0);
+            return;
+        }
+
+        stagnant = (improved ? 0 : stagnant + 1);
+        update_bounds();
+
+        int every = ctx.param.aco_p.global_every;
+        if (every && it % every == 0)
+            mmas_trail(best_path, best_fit);
+        else
+            mmas_trail(colony[best_ant].tour, colony[best_ant].fit);
+
+        if (ctx.param.aco_p.stagnation && stagnant >= ctx.param.aco_p.stagnation)
+        {
+            fill(trail_phero.begin(), trail_phero.end(), tau_max);
+            stagnant = 0;
+        }
     }
 
     void simulation()
@@ -155,16 +474,22 @@ class ACO
         */
 
         int it = 1;
+        convergence_monitor monitor;
 
-        while (it < utilities::param.aco_p.max_generations)
+        while (it < ctx.param.aco_p.max_generations && !utilities::should_stop(best_fit))
         {
-            if (utilities::param.aco_p.verbose)
+            if (ctx.param.aco_p.verbose)
                 print_verbose(it);  
 
-            ants_for_sugar();
-            
-            for (auto& e : trail_phero)
-                e.second -= utilities::param.aco_p.decay;
+            ants_for_sugar(it);
+            reduce_generation(it);
+            utilities::share(best_path, best_fit);
+
+            monitor_action action = monitor.observe(best_fit);
+            if (action == MONITOR_STOP)
+                break;
+            if (action == MONITOR_RESTART)
+                restart_trails(it);
 
             it++;
         }
@@ -179,13 +504,15 @@ class ACO
 
         cout << "ACO Generation " << x << ":\n";
         cout << "Best: " << best_fit << " cust\n";
+        if (ctx.lower_bound > 0)
+            cout << "Gap: " << utilities::gap(best_fit) << "%\n";
         
-        if (utilities::param.ga_p.simple_verbose == 0)
+        if (ctx.param.ga_p.simple_verbose == 0)
         {
             cout << "Path: ";
             for (int i = 0; i < nodes; i++)
             {
-                cout << best_path[i];
+                cout << utilities::original(best_path[i]);
                 if (i + 1 < nodes)
                 {
                     cout << " ";
@@ -199,20 +526,53 @@ class ACO
     {
         /*
             Objective:
-                Initialize the attractiveness and pheromone trail maps.
+                Initialize the attractiveness and pheromone trail matrices and the scratch buffers of the colony.
         */
 
-        for (int i = 0; i < nodes; i++)
+        candidates = min(ctx.param.aco_p.candidates, nodes - 1);
+
+        if (candidates)
         {
-            for (int j = i; j < nodes; j++)
+            neighbors = utilities::candidate_lists(candidates);
+            cand_choice.assign(nodes * candidates, 0);
+            attr.assign(nodes * candidates, 0);
+            trail_phero.assign(nodes * candidates, 1.0);
+
+            for (int i = 0; i < nodes * candidates; i++)
             {
-                LD dist = utilities::euclidian_distance(utilities::city[i], utilities::city[j]);
-                if (i == j || dist == 0)
-                    attr[{i, j}] = attr[{j, i}] = 0.000001, trail_phero[{i, j}] = trail_phero[{j, i}] = 1.0;
-                else
-                    attr[{i, j}] = attr[{j, i}] = 1.0 / dist, trail_phero[{i, j}] = trail_phero[{j, i}] = 1.0;
+                LD dist = utilities::distance(i / candidates, neighbors[i]);
+                attr[i] = (dist == 0 ? 0.000001 : 1.0 / dist);
             }
         }
+        else
+        {
+            choice.assign(nodes * nodes, 0);
+            attr.assign(nodes * nodes, 0);
+            trail_phero.assign(nodes * nodes, 1.0);
+
+            for (int i = 0; i < nodes; i++)
+            {
+                for (int j = i; j < nodes; j++)
+                {
+                    LD dist = utilities::distance(i, j);
+                    if (i == j || dist == 0)
+                        attr[i * nodes + j] = attr[j * nodes + i] = 0.000001;
+                    else
+                        attr[i * nodes + j] = attr[j * nodes + i] = 1.0 / dist;
+                }
+            }
+        }
+
+        colony.assign(ctx.param.aco_p.ants, ant(nodes));
+
+        if (ctx.param.aco_p.mmas)
+        {
+            update_bounds();
+            fill(trail_phero.begin(), trail_phero.end(), tau_max);
+            stagnant = 0;
+        }
+
+        seed_trails();
     }
 
     void init()
@@ -227,30 +587,37 @@ class ACO
     
 public:
 
-    ACO()
+    ACO(context& instance) : ctx(instance)
     {
         /*
             Objective:
-                Constructor for initializing the ACO algorithm.
+                Constructor for initializing the ACO algorithm, starting from the configured construction heuristic.
+
+            Parameters:
+                - instance: Context of the solve.
         */
 
-        nodes = utilities::n_cities;
-        vector<bool> contain(nodes, 0);
-        best_path.assign(nodes, -1);
-        utilities::random_path((utilities::param.aco_p.fix_init == -1 ? utilities::random_range(0, nodes) : utilities::param.aco_p.fix_init), 0, best_fit, best_path, contain);
+        context_scope scope(ctx);
+        nodes = ctx.n_cities;
+        int initial = (ctx.param.aco_p.fix_init == -1 ? utilities::random_range(0, nodes) : ctx.param.aco_p.fix_init);
+        best_path = construction::build(ctx.param.init, initial);
+        rotate(best_path.begin(), find(best_path.begin(), best_path.end(), initial), best_path.end());
+        best_fit = utilities::Fx_fit(best_path, nodes);
     }
     
-    ACO(vector<int> path)
+    ACO(context& instance, vector<int> path) : ctx(instance)
     {
         /*
             Objective:
                 Constructor for initializing the ACO algorithm with a specified initial path.
 
             Parameters:
+                - instance: Context of the solve.
                 - path: Initial path for the ACO algorithm.
         */
 
-        nodes = utilities::n_cities;
+        context_scope scope(ctx);
+        nodes = ctx.n_cities;
         best_path = path;
         best_fit = utilities::Fx_fit(path, nodes);
     }
@@ -262,8 +629,11 @@ public:
                 Activate the ACO algorithm to find the optimal solution for the TSP.
         */
 
+        context_scope scope(ctx);
+        rng_scope stream(RNG_ACO);
         init();
         simulation();
+        ctx.elites.offer(best_path, best_fit);
     } 
 
     vector<int> get_best_path()
@@ -278,7 +648,7 @@ public:
         return best_path;
     }
 
-    LD get_best_fit()
+    COST get_best_fit()
     {
         /*
             Objective:
@@ -5,6 +5,17 @@
 #include "ACO.hpp"
 #include "grasp.hpp"
 #include "ABC.hpp"
+#include "construction.hpp"
+#include "bound.hpp"
+#include "ils.hpp"
+#include "tabu.hpp"
+#include "gpx.hpp"
+
+// Decimal digits of costs and metrics in the report, enough for MAE/MSE/R2 on real distances.
+#define REPORT_DIGITS 4
+
+// Batch instances larger than this run one after another with the whole thread pool for their own parallel loops.
+#define BATCH_PARALLEL_LIMIT 500
 
 
 class TSP
@@ -12,9 +23,49 @@ class TSP
 	/*
 		Objective:
 			Class for solving the Traveling Salesman Problem (TSP) using various optimization algorithms.
+			Works on the context it was built with, so several TSP objects may solve different contexts concurrently.
 	*/
 
-	void active_metrics(LD best)
+	context& ctx;
+
+	bool limited = false;
+	bool quiet = false;
+	chrono::steady_clock::time_point finish, stage_finish;
+
+	bool begin_stage(int stage)
+	{
+		/*
+			Objective:
+				Give a stage its share of the remaining time budget: the remaining time is split among this stage and the
+				following enabled ones by their time_shares, so time left unused by earlier stages rolls over.
+
+			Parameters:
+				- stage: Index of the stage in hybrid.
+
+			Returns:
+				False when the budget is spent or the stage has no share, so the stage is skipped.
+		*/
+
+		if (!limited)
+			return true;
+
+		auto now = chrono::steady_clock::now();
+		LD weight = 0;
+
+		for (int s = stage; s < (int)ctx.param.hybrid.size(); s++)
+			if (ctx.param.hybrid[s])
+				weight += ctx.param.time_shares[s];
+
+		if (now >= finish || ctx.param.time_shares[stage] <= 0)
+			return false;
+
+		auto budget = chrono::duration_cast<chrono::steady_clock::duration>((finish - now) * (double)(ctx.param.time_shares[stage] / weight));
+		stage_finish = now + budget;
+		ctx.stop_token.expire_at(stage_finish);
+		return true;
+	}
+
+	void active_metrics(COST best)
 	{
 		/*
 			Objective:
@@ -24,127 +75,594 @@ class TSP
 				- best: The best fitness value obtained.
 		*/
 
-		if(utilities::param.metrics[0])
-			cout << "**MAE:** "<< utilities::calculateMAE(best, utilities::input_predicted) << (utilities::param.markdown ?  " <br>" : "")  << endl;
+		if(ctx.param.metrics[0])
+			cout << "**MAE:** "<< utilities::calculateMAE(best, ctx.input_predicted) << (ctx.param.markdown ?  " <br>" : "")  << endl;
 
-		if(utilities::param.metrics[1])
-			cout << "**MSE:** "<< utilities::calculateMSE(best, utilities::input_predicted) << (utilities::param.markdown ? " <br>" : "")  <<endl;
+		if(ctx.param.metrics[1])
+			cout << "**MSE:** "<< utilities::calculateMSE(best, ctx.input_predicted) << (ctx.param.markdown ? " <br>" : "")  <<endl;
 
-		if(utilities::param.metrics[2])
-			cout << "**R2:** "<< utilities::calculateR2(best, utilities::input_predicted) << (utilities::param.markdown ? " <br>" : "")  << endl;
+		if(ctx.param.metrics[2])
+			cout << "**R2:** "<< utilities::calculateR2(best, ctx.input_predicted) << (ctx.param.markdown ? " <br>" : "")  << endl;
 	}
 
-public:
-	void run()
+	void report_gap(const string& stage, COST best)
 	{
 		/*
 			Objective:
-				Run the TSP solver using different hybrid optimization algorithms.
+				Print the gap of the best tour to the lower bound after a stage, when the bound was computed.
 
+			Parameters:
+				- stage: Name of the stage that just finished.
+				- best: The best fitness value so far.
 		*/
-		auto start = chrono::system_clock::now();
-		genetic ga(utilities::n_cities);
-		LD best = INF;
-		vector<int> path;
 
-		for(int i = 0;i<utilities::n_cities;i++){
-			path.push_back(i);
+		if (ctx.lower_bound > 0 && !quiet)
+			cout << "**Gap after " << stage << ":** " << utilities::gap(best) << "%" << (ctx.param.markdown ? " <br>" : "") << endl;
+	}
+
+	void merge_elites(vector<int>& path, COST& best)
+	{
+		/*
+			Objective:
+				Merge the best tour with the other tours of the elite pool by partition crossover, keeping every child
+				cheaper than the current best, until a full pass over the pool gives no improvement.
+
+			Parameters:
+				- path: Best tour so far, updated in place.
+				- best: Its fitness value.
+		*/
+
+		vector<pair<COST, vector<int>>> elites = ctx.elites.tours();
+		bool improved = true, merged = false;
+
+		while (improved)
+		{
+			improved = false;
+			for (auto& elite : elites)
+			{
+				vector<int> child;
+				COST fit;
+
+				if (partition_crossover::merge(path, best, elite.second, elite.first, child, fit))
+				{
+					path = child;
+					best = fit;
+					improved = merged = true;
+				}
+			}
 		}
 
-		best=utilities::Fx_fit(path,utilities::n_cities);
-		
-		if (utilities::param.hybrid[0])
+		if (merged)
+			report_gap("GPX", best);
+	}
+
+	template <class solver>
+	void from_elites(vector<int>& path, COST& best)
+	{
+		/*
+			Objective:
+				Run a trajectory solver from the best tour and then from the next cheapest tours of the elite pool, up to
+				elite_starts runs in total. Under a time limit the remaining runs split the stage budget evenly.
+
+			Parameters:
+				- path: Best tour so far, updated in place.
+				- best: Its fitness value.
+		*/
+
+		vector<pair<COST, vector<int>>> starts = {{best, path}};
+		for (auto& elite : ctx.elites.tours())
+			if ((int)starts.size() < ctx.param.elite_starts && elite.second != path)
+				starts.push_back(elite);
+
+		for (int i = 0; i < (int)starts.size() && !utilities::gap_reached(best); i++)
 		{
+			if (limited)
+			{
+				auto now = chrono::steady_clock::now();
+				if (now >= stage_finish)
+					break;
+				ctx.stop_token.expire_at(now + (stage_finish - now) / ((int)starts.size() - i));
+			}
+
+			solver run(ctx, starts[i].second, starts[i].first);
+			COST fit = run.solution();
+
+			if (fit < best)
+			{
+				best = fit;
+				path = run.best_solution;
+			}
+		}
+	}
+
+	void pipeline(vector<int>& path, COST& best)
+	{
+		/*
+			Objective:
+				Run the enabled stages one after another, each starting from the best tour of the previous ones.
+				Under a time limit each stage gets its share of the remaining budget.
+
+			Parameters:
+				- path: Best tour so far, updated in place.
+				- best: Its fitness value.
+		*/
+
+		if (ctx.param.hybrid[0] && !utilities::gap_reached(best) && begin_stage(0))
+		{
+			genetic ga(ctx);
 			ga.activate();
 			best = ga.best_fit();
 			path = ga.best_path();
+			report_gap("GA", best);
 		}
 
-		if (utilities::param.hybrid[1])
+		if (ctx.param.hybrid[1] && !utilities::gap_reached(best) && begin_stage(1))
 		{
-			annealing ann(path, best);
-			LD best_ann = ann.solution();
-			
-			if (best_ann < best)
-			{
-				best = best_ann;
-				path = ann.best_solution;
-			}
+			from_elites<annealing>(path, best);
+			report_gap("SA", best);
 		}
 
-		if (utilities::param.hybrid[2])
+		if (ctx.param.hybrid[2] && !utilities::gap_reached(best) && begin_stage(2))
 		{
-			grasp gra(path, best);
-			LD best_gra = gra.solution();
-
-			if (best_gra < best)
-			{
-				best = best_gra;
-				path = gra.best_solution;
-			}
+			from_elites<grasp>(path, best);
+			report_gap("GRASP", best);
 		}
 
-		if (utilities::param.hybrid[3])
+		if (ctx.param.hybrid[3] && !utilities::gap_reached(best) && begin_stage(3))
 		{
-			ACO aco(path);
+			ACO aco(ctx, path);
 			aco.active();
-			LD best_aco_fit = aco.get_best_fit();
+			COST best_aco_fit = aco.get_best_fit();
 			
 			if(best_aco_fit < best)
 			{
 				best = best_aco_fit;
 				path = aco.get_best_path();
 			}
+			report_gap("ACO", best);
 		}
 
-		if (utilities::param.hybrid[4])
+		if (ctx.param.hybrid[4] && !utilities::gap_reached(best) && begin_stage(4))
 		{
-			ABC abc(path, best);
-			LD best_abc = abc.solution();
+			ABC abc(ctx, path, best);
+			COST best_abc = abc.solution();
 
 			if (best_abc < best)
 			{
 				best = best_abc;
 				path = abc.best_solution;
 			}
+			report_gap("ABC", best);
 		}
-		
-    	auto end = chrono::system_clock::now();
+
+		if (ctx.param.hybrid[5] && !utilities::gap_reached(best) && begin_stage(5))
+		{
+			ils local(ctx, path, best);
+			COST best_ils = local.solution();
+
+			if (best_ils < best)
+			{
+				best = best_ils;
+				path = local.best_solution;
+			}
+			report_gap("ILS", best);
+		}
+
+		if (ctx.param.hybrid[6] && !utilities::gap_reached(best) && begin_stage(6))
+		{
+			tabu ts(ctx, path, best);
+			COST best_ts = ts.solution();
+
+			if (best_ts < best)
+			{
+				best = best_ts;
+				path = ts.best_solution;
+			}
+			report_gap("tabu", best);
+		}
+	}
+
+	void portfolio(vector<int>& path, COST& best)
+	{
+		/*
+			Objective:
+				Run the enabled stages at the same time, one thread each, all starting from the same tour. They exchange
+				tours through the shared incumbent at their checkpoints, so the elapsed time is that of the slowest stage.
+				Under a time limit every stage runs until the global deadline.
+				The stages share the thread pool (a stage that finds it busy runs its parallel loops inline), and the
+				result depends on the thread schedule.
+
+			Parameters:
+				- path: Starting tour, replaced by the best tour found.
+				- best: Its fitness value.
+		*/
+
+		incumbent shared(path, best);
+		vector<thread> stages;
+		const vector<int> start = path;
+		const COST start_fit = best;
+
+		ctx.shared = &shared;
+
+		if (ctx.param.hybrid[0])
+			stages.emplace_back([&]()
+			{
+				context_scope scope(ctx);
+				genetic ga(ctx);
+				ga.activate();
+				shared.push(ga.best_path(), ga.best_fit());
+			});
+
+		if (ctx.param.hybrid[1])
+			stages.emplace_back([&]()
+			{
+				context_scope scope(ctx);
+				annealing ann(ctx, start, start_fit);
+				COST fit = ann.solution();
+				shared.push(ann.best_solution, fit);
+			});
+
+		if (ctx.param.hybrid[2])
+			stages.emplace_back([&]()
+			{
+				context_scope scope(ctx);
+				grasp gra(ctx, start, start_fit);
+				COST fit = gra.solution();
+				shared.push(gra.best_solution, fit);
+			});
+
+		if (ctx.param.hybrid[3])
+			stages.emplace_back([&]()
+			{
+				context_scope scope(ctx);
+				ACO aco(ctx, start);
+				aco.active();
+				shared.push(aco.get_best_path(), aco.get_best_fit());
+			});
+
+		if (ctx.param.hybrid[4])
+			stages.emplace_back([&]()
+			{
+				context_scope scope(ctx);
+				ABC abc(ctx, start, start_fit);
+				COST fit = abc.solution();
+				shared.push(abc.best_solution, fit);
+			});
+
+		if (ctx.param.hybrid[5])
+			stages.emplace_back([&]()
+			{
+				context_scope scope(ctx);
+				ils local(ctx, start, start_fit);
+				COST fit = local.solution();
+				shared.push(local.best_solution, fit);
+			});
+
+		if (ctx.param.hybrid[6])
+			stages.emplace_back([&]()
+			{
+				context_scope scope(ctx);
+				tabu ts(ctx, start, start_fit);
+				COST fit = ts.solution();
+				shared.push(ts.best_solution, fit);
+			});
+
+		for (auto& stage : stages)
+			stage.join();
+
+		ctx.shared = nullptr;
+		shared.pull(path, best);
+		report_gap("portfolio", best);
+	}
+
+	COST solve(vector<int>& path)
+	{
+		/*
+			Objective:
+				Solve the instance once: construction tour, optional lower bound, then the stages (pipeline or
+				portfolio) and the final merge of the elite pool.
+
+			Parameters:
+				- path: Receives the best tour found.
+
+			Returns:
+				Its fitness value.
+		*/
+
+		context_scope scope(ctx);
+		rng_scope stream(RNG_MAIN);
+		path = construction::build(ctx.param.init);
+		COST best = utilities::Fx_fit(path, ctx.n_cities);
+
+		// The elite pool starts from the construction tour and collects the tours of every stage.
+		ctx.elites.reset(ctx.param.elite_size, ctx.param.elite_distance * ctx.n_cities / 100);
+		ctx.elites.offer(path, best);
+
+		// The budget starts with the run; the bound and the portfolio stages stop at the global deadline.
+		limited = ctx.param.time_limit > 0;
+		if (limited)
+		{
+			finish = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(ctx.param.time_limit));
+			ctx.stop_token.expire_at(finish);
+		}
+
+		// Stages are skipped once the best tour is within the target gap of the lower bound.
+		if (ctx.param.bound_p.active)
+		{
+			held_karp hk(ctx);
+			hk.solve();
+			if (!quiet)
+			{
+				cout << fixed << setprecision(REPORT_DIGITS);
+				cout << "**Lower bound:** " << ctx.lower_bound << (ctx.param.markdown ? " <br>" : "") << endl;
+			}
+			report_gap("construction", best);
+		}
+
+		if (ctx.param.portfolio)
+			portfolio(path, best);
+		else
+			pipeline(path, best);
+
+		merge_elites(path, best);
+
+		ctx.stop_token.clear_deadline();
+		return best;
+	}
+
+public:
+	TSP(context& instance) : ctx(instance) {}
+
+	void run()
+	{
+		/*
+			Objective:
+				Run the TSP solver using different hybrid optimization algorithms.
+
+		*/
+		context_scope scope(ctx);
+		auto start = chrono::system_clock::now();
+		vector<int> path;
+		COST best = solve(path);
+
+		auto end = chrono::system_clock::now();
 		chrono::duration<double> time = end - start;
-		cout << "**Elapsed Time:** " << time.count() << " seconds" << (utilities::param.markdown ? " <br>" : "") << endl;
-		cout << "**Fit:** "<< best  << (utilities::param.markdown ? " <br>" : "") << endl;
+		cout << fixed << setprecision(REPORT_DIGITS);
+		cout << "**Elapsed Time:** " << time.count() << " seconds" << (ctx.param.markdown ? " <br>" : "") << endl;
+		cout << "**Fit:** "<< best  << (ctx.param.markdown ? " <br>" : "") << endl;
+		cout << "**Seed:** "<< ctx.param.seed  << (ctx.param.markdown ? " <br>" : "") << endl;
+		if (ctx.lower_bound > 0)
+			cout << "**Gap:** "<< utilities::gap(best) << "%" << (ctx.param.markdown ? " <br>" : "") << endl;
 		cout << "**path:** ";
-		for(auto i :path)cout<<i<<" ";
-		cout << (utilities::param.markdown ? " <br>" : "")  <<endl;
+		for(auto i :path)cout<<utilities::original(i)<<" ";
+		cout << (ctx.param.markdown ? " <br>" : "")  <<endl;
 
-		if(utilities::param.metrics[0] + utilities::param.metrics[1] + utilities::param.metrics[2])
+		if(ctx.param.metrics[0] + ctx.param.metrics[1] + ctx.param.metrics[2])
 		{
 			active_metrics(best);
 		}
 	}
 
-	void best_params()
+	void benchmark()
+	{
+		/*
+			Objective:
+				Run the configured solver benchmark.runs times with the seeds seed, seed + 1, ... and report the
+				minimum, median, mean and standard deviation of the cost, the gap to the predicted value of the input,
+				the time to reach the target cost and the throughput. Per-run results and the summary are also written
+				as CSV files. Every run solves its own copy of the context, and the runs are spread over the thread
+				pool (each run then executes its own parallel loops inline).
+		*/
+
+		context_scope scope(ctx);
+		benchmark_params& p = ctx.param.benchmark_p;
+		uint64_t base_seed = ctx.param.seed;
+		LD target = (p.target > 0 ? p.target : ctx.input_predicted);
+		vector<COST> costs(p.runs);
+		vector<double> seconds(p.runs), to_target(p.runs);
+		vector<unique_ptr<context>> runs_ctx;
+
+		auto gap_to = [&](LD cost) { return (ctx.input_predicted > 0 ? (cost - ctx.input_predicted) / ctx.input_predicted * 100 : (LD)-1); };
+
+		for (int r = 0; r < p.runs; r++)
+			runs_ctx.emplace_back(new context(ctx, base_seed + r));
+
+		auto start = chrono::steady_clock::now();
+
+		utilities::pool().parallel_for(p.runs, [&](int r)
+		{
+			context& run_ctx = *runs_ctx[r];
+			context_scope run_scope(run_ctx);
+			TSP solver(run_ctx);
+			solver.quiet = true;
+			run_ctx.target_clock.arm(target);
+
+			auto begin = chrono::steady_clock::now();
+			vector<int> path;
+			costs[r] = solver.solve(path);
+			seconds[r] = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+			to_target[r] = run_ctx.target_clock.seconds();
+
+			// The final cost also counts, since the last stages do not report theirs through the stop checks.
+			if (to_target[r] < 0 && target > 0 && (LD)costs[r] <= target + 1e-9)
+				to_target[r] = seconds[r];
+		});
+
+		double total = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		vector<COST> sorted = costs;
+		sort(sorted.begin(), sorted.end());
+		int runs = p.runs, reached = 0;
+		LD mean = 0, deviation = 0, median = (runs % 2 ? (LD)sorted[runs / 2] : ((LD)sorted[runs / 2 - 1] + sorted[runs / 2]) / 2);
+		double mean_to_target = 0;
+
+		for (int r = 0; r < runs; r++)
+		{
+			mean += (LD)costs[r] / runs;
+			if (to_target[r] >= 0)
+				reached++, mean_to_target += to_target[r];
+		}
+		for (int r = 0; r < runs; r++)
+			deviation += ((LD)costs[r] - mean) * ((LD)costs[r] - mean);
+		deviation = sqrt(deviation / max(1, runs - 1));
+		mean_to_target = (reached ? mean_to_target / reached : -1);
+
+		string br = (ctx.param.markdown ? " <br>" : "");
+		cout << fixed << setprecision(REPORT_DIGITS);
+		cout << "**Runs:** " << runs << br << endl;
+		cout << "**Min:** " << sorted[0] << br << endl;
+		cout << "**Median:** " << median << br << endl;
+		cout << "**Mean:** " << mean << br << endl;
+		cout << "**Stddev:** " << deviation << br << endl;
+		if (ctx.input_predicted > 0)
+			cout << "**Gap to predicted (min / median / mean):** " << gap_to(sorted[0]) << "% / " << gap_to(median) << "% / " << gap_to(mean) << "%" << br << endl;
+		if (target > 0)
+			cout << "**Time to target:** " << mean_to_target << " seconds (" << reached << "/" << runs << " runs)" << br << endl;
+		cout << "**Throughput:** " << runs / total << " runs/second" << br << endl;
+
+		ofstream per_run(p.output + "_runs.csv");
+		per_run << fixed << setprecision(REPORT_DIGITS);
+		per_run << "run,seed,cost,gap,seconds,time_to_target" << endl;
+		for (int r = 0; r < runs; r++)
+			per_run << r << "," << base_seed + r << "," << costs[r] << "," << gap_to(costs[r]) << "," << seconds[r] << "," << to_target[r] << endl;
+
+		ofstream summary(p.output + "_summary.csv");
+		summary << fixed << setprecision(REPORT_DIGITS);
+		summary << "runs,min,median,mean,stddev,gap_min,gap_median,gap_mean,target,reached,time_to_target,runs_per_second" << endl;
+		summary << runs << "," << sorted[0] << "," << median << "," << mean << "," << deviation << "," << gap_to(sorted[0]) << "," << gap_to(median) << ","
+			<< gap_to(mean) << "," << target << "," << reached << "," << mean_to_target << "," << runs / total << endl;
+	}
+
+	void batch(const string& source, const string& output)
 	{
 		/*
 			Objective:
-				Finds the best average fitness and the shortest execution time among multiple runs of a genetic algorithm.
+				Solve many instances in one process: every .txt file of a directory, or every path listed (one per line)
+				in a file. Every slot of the thread pool owns one context, with the same parameters and seed, and loads
+				the instances it claims into it, so the stores of the context are reused from one instance to the next.
+				Small instances are spread over the slots (each one then executes its own parallel loops inline);
+				instances larger than BATCH_PARALLEL_LIMIT run afterwards one at a time, so their parallel loops get the
+				whole pool. Every instance is solved from a freshly seeded run state, so its result does not depend on
+				the other instances. One record per instance is printed and written to a CSV file, in input order.
 
+			Parameters:
+				- source: Directory of instances or file listing them.
+				- output: Path of the CSV file with one record per instance.
 		*/
-		LD best = INF, min_time = INF;
-		LD best_med =0, current_time = INF;
-		for(int j=0; j<5; j++)
+
+		context_scope scope(ctx);
+		vector<string> instances;
+
+		if (filesystem::is_directory(source))
 		{
-			auto start = chrono::system_clock::now();
-			genetic ga(utilities::n_cities);
-			ga.activate();
-			best_med += ga.best_fit();
-			auto end = chrono::system_clock::now();
-			chrono::duration<double> time = end - start;
-			if(time.count() < current_time) 
-				current_time = time.count();
-		}
-		best = best_med/5;
-		min_time = current_time;
-		cout  << "Best average fitness: " << best << " Shortest execution time: " <<  min_time <<endl; 
+			for (auto& entry : filesystem::directory_iterator(source))
+				if (entry.is_regular_file() && entry.path().extension() == ".txt")
+					instances.push_back(entry.path().string());
+			sort(instances.begin(), instances.end());
+		}
+		else
+		{
+			ifstream list(source);
+			string line;
+			while (getline(list, line))
+				if (!line.empty() && line[0] != '#')
+					instances.push_back(line);
+		}
+
+		int m = instances.size();
+		vector<int> cities(m, 0);
+		vector<char> readable(m, 0), deferred(m, 0);
+		vector<COST> costs(m, 0);
+		vector<LD> predicted(m, 0), lower_bound(m, 0), gap_bound(m, -1);
+		vector<double> seconds(m, 0);
+
+		thread_pool& workers = utilities::pool();
+		int slots = max(1, min(m, workers.size()));
+		vector<unique_ptr<context>> slots_ctx;
+		for (int s = 0; s < slots; s++)
+			slots_ctx.emplace_back(new context(ctx, ctx.param.seed));
+
+		// Solves instance i, already loaded into the context installed on the calling thread.
+		auto solve_loaded = [&](context& instance_ctx, int i)
+		{
+			instance_ctx.fallback_rng = philox(ctx.param.seed, RNG_THREAD);
+
+			TSP solver(instance_ctx);
+			solver.quiet = true;
+
+			auto begin = chrono::steady_clock::now();
+			vector<int> path;
+			costs[i] = solver.solve(path);
+			seconds[i] = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+			predicted[i] = instance_ctx.input_predicted;
+			lower_bound[i] = instance_ctx.lower_bound;
+			gap_bound[i] = utilities::gap(costs[i]);
+		};
+
+		atomic<int> next_instance(0);
+		workers.parallel_for(slots, [&](int s)
+		{
+			context& instance_ctx = *slots_ctx[s];
+			context_scope instance_scope(instance_ctx);
+
+			for (int i = next_instance++; i < m; i = next_instance++)
+			{
+				readable[i] = utilities::input_points(instances[i]);
+				cities[i] = instance_ctx.n_cities;
+
+				if (!readable[i] || cities[i] < 3)
+					continue;
+
+				if (cities[i] > BATCH_PARALLEL_LIMIT)
+					deferred[i] = 1;
+				else
+					solve_loaded(instance_ctx, i);
+			}
+		});
+
+		for (int i = 0; i < m; i++)
+		{
+			if (!deferred[i])
+				continue;
+
+			context_scope instance_scope(*slots_ctx[0]);
+			utilities::input_points(instances[i]);
+			solve_loaded(*slots_ctx[0], i);
+		}
+
+		ofstream records(output);
+		records << fixed << setprecision(REPORT_DIGITS);
+		records << "instance,cities,cost,predicted,gap_predicted,lower_bound,gap_bound,seconds,seed" << endl;
+
+		string br = (ctx.param.markdown ? " <br>" : "");
+		cout << fixed << setprecision(REPORT_DIGITS);
+
+		for (int i = 0; i < m; i++)
+		{
+			if (!readable[i])
+			{
+				cout << "**" << instances[i] << ":** skipped, the file could not be opened or read" << br << endl;
+				continue;
+			}
+
+			if (cities[i] < 3)
+			{
+				cout << "**" << instances[i] << ":** skipped, fewer than 3 cities" << br << endl;
+				continue;
+			}
+
+			LD gap_predicted = (predicted[i] > 0 ? ((LD)costs[i] - predicted[i]) / predicted[i] * 100 : (LD)-1);
+
+			cout << "**" << instances[i] << ":** " << costs[i] << " in " << seconds[i] << " seconds";
+			if (predicted[i] > 0)
+				cout << ", gap to predicted " << gap_predicted << "%";
+			if (lower_bound[i] > 0)
+				cout << ", gap to bound " << gap_bound[i] << "%";
+			cout << br << endl;
+
+			records << instances[i] << "," << cities[i] << "," << costs[i] << "," << predicted[i] << "," << gap_predicted << "," << lower_bound[i] << ","
+				<< gap_bound[i] << "," << seconds[i] << "," << ctx.param.seed << endl;
+		}
 	}
 };
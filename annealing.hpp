@@ -13,23 +13,25 @@ public:
             tf - Final temperature.
             l - Number of iterations (exchanges) to be performed on the current solution.
             alpha - Temperature variation rate.
+            ctx - Context of the solve.
             best_solution - Vector containing the best path.
             s_cost - Cost of the current best_solution.
     */
 
+    context& ctx;
     LD t0;
     LD tf;
     int l;
     LD alpha;
     vector<int> best_solution;
-    LD s_cost;
+    COST s_cost;
 
-    annealing(vector<int> s_initial, LD s_cost_initial)
+    annealing(context& instance, vector<int> s_initial, COST s_cost_initial) : ctx(instance)
     {
-        t0 = utilities::param.ann_p.t0;
-        tf = utilities::param.ann_p.tf;
-        l = utilities::param.ann_p.l;
-        alpha = utilities::param.ann_p.alpha;
+        t0 = ctx.param.ann_p.t0;
+        tf = ctx.param.ann_p.tf;
+        l = ctx.param.ann_p.l;
+        alpha = ctx.param.ann_p.alpha;
         best_solution = s_initial;
         s_cost = s_cost_initial;
     }
@@ -41,27 +43,28 @@ public:
         std::swap(path[idx1], path[idx2]);
     }
 
-    LD solution()
+    COST solution()
     {
+        context_scope scope(ctx);
+        rng_scope stream(RNG_SA);
         LD t = t0;
         vector<int> local_s = best_solution;
-        LD local_cost = s_cost;
+        COST local_cost = s_cost;
+        convergence_monitor monitor;
 
-        while (t >= tf)
+        while (t >= tf && !utilities::should_stop(s_cost))
         {
-            for (int i = 0; i < l; i++)
+            for (int i = 0; i < l && !ctx.stop_token.stop_requested(); i++)
             {
-                vector<int> n_s = local_s;
+                // Same draws as perturbPath, scored by the exact delta of the exchange instead of a full evaluation.
+                int idx1 = utilities::random_range(0, local_s.size() - 1);
+                int idx2 = utilities::random_range(0, local_s.size() - 1);
+                COST delta = utilities::exchange_delta(local_s, idx1, idx2);
 
-                perturbPath(n_s);
-
-                LD ns_cost = utilities::Fx_fit(n_s, utilities::n_cities);
-                LD delta = ns_cost - local_cost;
-
-                if (delta < 0 || exp(-delta / t) > ((LD)rand() / RAND_MAX))
+                if (delta < 0 || exp(-(LD)delta / t) > utilities::random_range_double(0, 1))
                 {
-                    local_cost = ns_cost;
-                    local_s = n_s;
+                    swap(local_s[idx1], local_s[idx2]);
+                    local_cost += delta;
                 }
 
                 if (local_cost <= s_cost)
@@ -72,8 +75,32 @@ public:
 
                 t = t * alpha;
             }
+
+            // Deltas accumulate rounding with real distances: re-measure the tours once per temperature block.
+            local_cost = utilities::Fx_fit(local_s, ctx.n_cities);
+            s_cost = utilities::Fx_fit(best_solution, ctx.n_cities);
+
+            // Portfolio checkpoint: continue from the incumbent when another solver found a better tour.
+            if (utilities::share(best_solution, s_cost))
+            {
+                local_s = best_solution;
+                local_cost = s_cost;
+            }
+
+            // Stagnation: reheat and continue from a double-bridge kick of the best solution, or stop.
+            monitor_action action = monitor.observe(s_cost);
+            if (action == MONITOR_STOP)
+                break;
+            if (action == MONITOR_RESTART)
+            {
+                t = t0;
+                local_s = best_solution;
+                utilities::double_bridge(local_s, utilities::rng());
+                local_cost = utilities::Fx_fit(local_s, ctx.n_cities);
+            }
         }
 
+        ctx.elites.offer(best_solution, s_cost);
         return s_cost;
     }
 };
@@ -0,0 +1,255 @@
+#pragma once
+#include "library.hpp"
+#include "construction.hpp"
+
+class held_karp
+{
+	/*
+		Objective:
+			Held-Karp lower bound: 1-trees (a minimum spanning tree over cities 1..n - 1 plus the two cheapest edges
+			of city 0) under the costs d(i, j) + pi[i] + pi[j], with the penalties pi tuned by subgradient optimization.
+			The bound is published in ctx.lower_bound and, on request, the alpha-nearness candidate lists in
+			ctx.alpha_near.
+
+		Attributes:
+			ctx: Context of the solve.
+			n: Number of cities.
+			pi: Penalties of the best bound found.
+			parent: Tree parent of every city in the last 1-tree (city 0 has none, city 1 is the root).
+			degree: Degree of every city in the last 1-tree.
+			special: The two cities joined to city 0 in the last 1-tree.
+	*/
+
+	context& ctx;
+	int n;
+	vector<LD> pi, parent_cost;
+	vector<int> parent, degree;
+	int special[2];
+
+	LD cost(const int& i, const int& j, const vector<LD>& penalty)
+	{
+		return (LD)utilities::distance(i, j) + penalty[i] + penalty[j];
+	}
+
+	LD one_tree(const vector<LD>& penalty)
+	{
+		/*
+			Objective:
+				Build the minimum 1-tree under the given penalties (Prim, O(n^2)).
+			Returns:
+				Its penalized length minus twice the sum of the penalties, a lower bound on the optimal tour.
+		*/
+
+		vector<LD> key(n, INF);
+		vector<char> in_tree(n, 0);
+		LD length = 0;
+
+		degree.assign(n, 0);
+		parent.assign(n, -1);
+		parent_cost.assign(n, 0);
+		key[1] = 0;
+
+		for (int step = 1; step < n; step++)
+		{
+			int u = -1;
+			for (int i = 1; i < n; i++)
+				if (!in_tree[i] && (u == -1 || key[i] < key[u]))
+					u = i;
+
+			in_tree[u] = 1;
+			if (parent[u] != -1)
+			{
+				length += key[u];
+				parent_cost[u] = key[u];
+				degree[u]++;
+				degree[parent[u]]++;
+			}
+
+			for (int v = 1; v < n; v++)
+			{
+				if (in_tree[v])
+					continue;
+
+				LD c = cost(u, v, penalty);
+				if (c < key[v])
+					key[v] = c, parent[v] = u;
+			}
+		}
+
+		special[0] = special[1] = -1;
+		for (int v = 1; v < n; v++)
+		{
+			LD c = cost(0, v, penalty);
+			if (special[0] == -1 || c < cost(0, special[0], penalty))
+				special[1] = special[0], special[0] = v;
+			else if (special[1] == -1 || c < cost(0, special[1], penalty))
+				special[1] = v;
+		}
+
+		for (int s = 0; s < 2; s++)
+		{
+			length += cost(0, special[s], penalty);
+			degree[special[s]]++;
+		}
+		degree[0] = 2;
+
+		for (int i = 0; i < n; i++)
+			length -= 2 * penalty[i];
+
+		return length;
+	}
+
+	void alpha_nearness(int k)
+	{
+		/*
+			Objective:
+				Compute the k alpha-nearest cities of every city under the best penalties: alpha(i, j) is the increase of
+				the minimum 1-tree length when it is forced to contain the edge (i, j), that is, c(i, j) minus the largest
+				cost on the tree path between i and j (or minus the second edge of city 0 for edges of city 0).
+				Ties are broken by the penalized cost. Cities are processed in parallel.
+
+			Parameters:
+				- k: Number of candidates per city.
+		*/
+
+		one_tree(pi);
+
+		vector<vector<pair<int, LD>>> tree(n);
+		for (int v = 1; v < n; v++)
+		{
+			if (parent[v] == -1)
+				continue;
+			tree[v].push_back({parent[v], parent_cost[v]});
+			tree[parent[v]].push_back({v, parent_cost[v]});
+		}
+
+		LD second = cost(0, special[1], pi);
+		k = max(0, min(k, n - 1));
+		ctx.alpha_near.assign(n * k, 0);
+
+		utilities::pool().parallel_for(n, [&](int i)
+		{
+			vector<LD> beta(n, 0);
+			vector<pair<pair<LD, LD>, int>> order;
+			vector<int> stack;
+			vector<char> seen(n, 0);
+
+			// Largest tree edge on the path from i to every other city (city 0 is not in the tree).
+			if (i != 0)
+			{
+				stack.push_back(i);
+				seen[i] = 1;
+				while (!stack.empty())
+				{
+					int u = stack.back();
+					stack.pop_back();
+					for (auto& e : tree[u])
+					{
+						if (seen[e.first])
+							continue;
+						seen[e.first] = 1;
+						beta[e.first] = max(beta[u], e.second);
+						stack.push_back(e.first);
+					}
+				}
+			}
+
+			for (int j = 0; j < n; j++)
+			{
+				if (j == i)
+					continue;
+
+				LD c = cost(i, j, pi), alpha;
+				if (i == 0 || j == 0)
+					alpha = ((i == 0 ? j : i) == special[0] || (i == 0 ? j : i) == special[1] ? 0 : max((LD)0, c - second));
+				else
+					alpha = max((LD)0, c - beta[j]);
+
+				order.push_back({{alpha, c}, j});
+			}
+
+			partial_sort(order.begin(), order.begin() + k, order.end());
+
+			for (int j = 0; j < k; j++)
+				ctx.alpha_near[i * k + j] = order[j].second;
+		});
+	}
+
+public:
+	LD bound = 0;
+
+	held_karp(context& instance) : ctx(instance)
+	{
+		n = ctx.n_cities;
+		pi.assign(n, 0);
+	}
+
+	LD solve()
+	{
+		/*
+			Objective:
+				Run the subgradient optimization: pi[i] moves by t * (degree[i] - 2), with the Polyak step
+				t = lambda * (UB - w) / |g|^2 against the construction tour as upper bound UB; lambda is halved after
+				bound.period iterations without improvement. Stops early when the 1-tree is a tour (the bound is optimal).
+
+			Returns:
+				The best lower bound found, also stored in ctx.lower_bound.
+		*/
+
+		context_scope scope(ctx);
+		bound_params& p = ctx.param.bound_p;
+
+		if (n < 3)
+		{
+			ctx.lower_bound = 0;
+			return 0;
+		}
+
+		vector<LD> current(n, 0);
+		LD ub = (LD)utilities::Fx_fit(construction::build(ctx.param.init), n);
+		LD lambda = 2;
+		int stall = 0;
+
+		bound = -INF;
+
+		for (int it = 0; it < p.iterations && lambda > 1e-6 && !ctx.stop_token.stop_requested(); it++)
+		{
+			LD w = one_tree(current);
+
+			if (w > bound + 1e-9)
+			{
+				bound = w;
+				pi = current;
+				stall = 0;
+			}
+			else if (++stall >= p.period)
+			{
+				lambda /= 2;
+				stall = 0;
+			}
+
+			LD norm = 0;
+			for (int i = 0; i < n; i++)
+				norm += (LD)(degree[i] - 2) * (degree[i] - 2);
+
+			if (norm == 0 || ub - w <= 0)
+				break;
+
+			LD t = lambda * (ub - w) / norm;
+			for (int i = 0; i < n; i++)
+				current[i] += t * (degree[i] - 2);
+		}
+
+		// With integer distances every tour has an integer length, so the bound rounds up.
+		if (ctx.weight_type != DIST_EUC || is_integral<COST>::value)
+			bound = ceil(bound - 1e-6);
+
+		bound = max(bound, (LD)0);
+		ctx.lower_bound = bound;
+
+		if (p.candidates > 0)
+			alpha_nearness(p.candidates);
+
+		return bound;
+	}
+};
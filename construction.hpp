@@ -0,0 +1,355 @@
+#pragma once
+#include "library.hpp"
+
+class construction
+{
+	/*
+		Objective:
+			Fast construction heuristics used to seed the metaheuristics with a reasonable tour instead of the
+			identity tour or a random permutation.
+			Available methods: "identity", "nn" (nearest neighbor over a grid index), "greedy" (greedy edge),
+			"sfc" (space-filling curve) and "christofides" (MST + greedy matching of odd vertices + shortcuts).
+	*/
+
+	static bool planar()
+	{
+		/*
+			Objective:
+				Whether the distance grows with the Euclidean distance of the coordinates, so a grid index is valid.
+		*/
+
+		return utilities::ctx().weight_type != DIST_GEO;
+	}
+
+	static LD planar_distance(const int& a, const int& b)
+	{
+		LD dx = utilities::ctx().xs[a] - utilities::ctx().xs[b], dy = utilities::ctx().ys[a] - utilities::ctx().ys[b];
+		return sqrt(dx * dx + dy * dy);
+	}
+
+	static int find(vector<int>& parent, int x)
+	{
+		while (parent[x] != x)
+			x = parent[x] = parent[parent[x]];
+		return x;
+	}
+
+public:
+	static vector<int> nearest_neighbor(int start)
+	{
+		/*
+			Objective:
+				Nearest neighbor tour. On planar instances the cities are bucketed in a uniform grid and each step scans
+				rings of cells around the current city until no closer city can exist, instead of every city.
+
+			Parameters:
+				- start: First city of the tour.
+		*/
+
+		int n = utilities::ctx().n_cities;
+		vector<int> path;
+		vector<char> visited(n, 0);
+		path.reserve(n);
+		path.push_back(start);
+		visited[start] = 1;
+
+		if (!planar())
+		{
+			for (int step = 1; step < n; step++)
+			{
+				int current = path.back(), best = -1;
+				COST best_dist = INF;
+
+				for (int i = 0; i < n; i++)
+					if (!visited[i] && utilities::distance(current, i) < best_dist)
+						best = i, best_dist = utilities::distance(current, i);
+
+				path.push_back(best);
+				visited[best] = 1;
+			}
+			return path;
+		}
+
+		LD min_x = *min_element(utilities::ctx().xs.begin(), utilities::ctx().xs.end());
+		LD min_y = *min_element(utilities::ctx().ys.begin(), utilities::ctx().ys.end());
+		LD max_x = *max_element(utilities::ctx().xs.begin(), utilities::ctx().xs.end());
+		LD max_y = *max_element(utilities::ctx().ys.begin(), utilities::ctx().ys.end());
+		int side = max(1, (int)sqrt(n / 2.0));
+		LD cell = max(max_x - min_x, max_y - min_y) / side + 1e-9;
+
+		auto cell_of = [&](int c, int& cx, int& cy)
+		{
+			cx = min(side - 1, (int)((utilities::ctx().xs[c] - min_x) / cell));
+			cy = min(side - 1, (int)((utilities::ctx().ys[c] - min_y) / cell));
+		};
+
+		// Cities of each cell in CSR form, with a count of the unvisited ones to skip empty cells.
+		vector<int> start_of(side * side + 1, 0), items(n), remaining(side * side, 0);
+		for (int i = 0; i < n; i++)
+		{
+			int cx, cy;
+			cell_of(i, cx, cy);
+			start_of[cx * side + cy + 1]++;
+		}
+		for (int i = 0; i < side * side; i++)
+			start_of[i + 1] += start_of[i];
+
+		vector<int> fill_at(start_of.begin(), start_of.end() - 1);
+		for (int i = 0; i < n; i++)
+		{
+			int cx, cy;
+			cell_of(i, cx, cy);
+			items[fill_at[cx * side + cy]++] = i;
+			remaining[cx * side + cy]++;
+		}
+
+		int sx, sy;
+		cell_of(start, sx, sy);
+		remaining[sx * side + sy]--;
+
+		for (int step = 1; step < n; step++)
+		{
+			int current = path.back(), best = -1, cx, cy;
+			LD best_dist = INF;
+			cell_of(current, cx, cy);
+
+			for (int r = 0; r < side; r++)
+			{
+				for (int x = max(0, cx - r); x <= min(side - 1, cx + r); x++)
+				{
+					for (int y = max(0, cy - r); y <= min(side - 1, cy + r); y++)
+					{
+						if (max(abs(x - cx), abs(y - cy)) != r || !remaining[x * side + y])
+							continue;
+
+						for (int k = start_of[x * side + y]; k < start_of[x * side + y + 1]; k++)
+						{
+							int c = items[k];
+							if (visited[c])
+								continue;
+
+							LD d = planar_distance(current, c);
+							if (d < best_dist || (d == best_dist && c < best))
+								best = c, best_dist = d;
+						}
+					}
+				}
+
+				// Any city in ring r + 1 or beyond is at least r * cell away.
+				if (best != -1 && best_dist <= r * cell)
+					break;
+			}
+
+			int bx, by;
+			cell_of(best, bx, by);
+			remaining[bx * side + by]--;
+			visited[best] = 1;
+			path.push_back(best);
+		}
+
+		return path;
+	}
+
+	static vector<int> space_filling_curve()
+	{
+		/*
+			Objective:
+				Tour visiting the cities in Hilbert curve order.
+		*/
+
+		return utilities::hilbert_order();
+	}
+
+	static vector<int> greedy_edge()
+	{
+		/*
+			Objective:
+				Greedy edge tour: candidate edges from the nearest neighbor lists are taken shortest first whenever
+				both ends have degree < 2 and no cycle is closed; the remaining fragments are then joined
+				greedily by their nearest free endpoints.
+		*/
+
+		int n = utilities::ctx().n_cities;
+		if (n < 3)
+			return nearest_neighbor(0);
+
+		int k = min(GREEDY_CANDIDATES, n - 1);
+		vector<int> neighbors = utilities::nearest_neighbors(k);
+		vector<pair<COST, pair<int, int>>> edges;
+
+		for (int i = 0; i < n; i++)
+			for (int j = 0; j < k; j++)
+				if (i < neighbors[i * k + j])
+					edges.push_back({utilities::distance(i, neighbors[i * k + j]), {i, neighbors[i * k + j]}});
+
+		sort(edges.begin(), edges.end());
+
+		vector<int> degree(n, 0), parent(n);
+		vector<array<int, 2>> adj(n, {-1, -1});
+		int taken = 0;
+
+		for (int i = 0; i < n; i++)
+			parent[i] = i;
+
+		auto link = [&](int a, int b)
+		{
+			adj[a][degree[a]++] = b;
+			adj[b][degree[b]++] = a;
+			parent[find(parent, a)] = find(parent, b);
+			taken++;
+		};
+
+		for (auto& e : edges)
+		{
+			int a = e.second.first, b = e.second.second;
+			if (degree[a] < 2 && degree[b] < 2 && find(parent, a) != find(parent, b))
+				link(a, b);
+		}
+
+		// Join the fragments: from a free endpoint, repeatedly link to the nearest free endpoint of another fragment.
+		while (taken < n - 1)
+		{
+			int a = -1;
+			for (int i = 0; i < n && a == -1; i++)
+				if (degree[i] < 2)
+					a = i;
+
+			int best = -1;
+			COST best_dist = INF;
+			for (int i = 0; i < n; i++)
+				if (degree[i] < 2 && find(parent, i) != find(parent, a) && utilities::distance(a, i) < best_dist)
+					best = i, best_dist = utilities::distance(a, i);
+
+			link(a, best);
+		}
+
+		vector<int> path;
+		int start = 0;
+		for (int i = 0; i < n; i++)
+			if (degree[i] < 2)
+				start = i;
+
+		for (int prev = -1, current = start; (int)path.size() < n;)
+		{
+			path.push_back(current);
+			int next = (adj[current][0] != prev ? adj[current][0] : adj[current][1]);
+			prev = current;
+			current = next;
+		}
+
+		return path;
+	}
+
+	static vector<int> christofides_lite()
+	{
+		/*
+			Objective:
+				Christofides-like tour: minimum spanning tree (Prim, O(n^2)), greedy nearest pairing of the
+				odd-degree vertices instead of a perfect matching, Euler tour, and shortcut of repeated cities.
+		*/
+
+		int n = utilities::ctx().n_cities;
+		vector<vector<int>> adj(n);
+		vector<COST> key(n, INF);
+		vector<int> from(n, -1);
+		vector<char> in_tree(n, 0);
+
+		key[0] = 0;
+		for (int step = 0; step < n; step++)
+		{
+			int u = -1;
+			for (int i = 0; i < n; i++)
+				if (!in_tree[i] && (u == -1 || key[i] < key[u]))
+					u = i;
+
+			in_tree[u] = 1;
+			if (from[u] != -1)
+			{
+				adj[u].push_back(from[u]);
+				adj[from[u]].push_back(u);
+			}
+
+			for (int v = 0; v < n; v++)
+			{
+				COST d = utilities::distance(u, v);
+				if (!in_tree[v] && d < key[v])
+					key[v] = d, from[v] = u;
+			}
+		}
+
+		vector<int> odd;
+		for (int i = 0; i < n; i++)
+			if (adj[i].size() % 2)
+				odd.push_back(i);
+
+		vector<char> matched(n, 0);
+		for (auto a : odd)
+		{
+			if (matched[a])
+				continue;
+
+			int best = -1;
+			for (auto b : odd)
+				if (b != a && !matched[b] && (best == -1 || utilities::distance(a, b) < utilities::distance(a, best)))
+					best = b;
+
+			matched[a] = matched[best] = 1;
+			adj[a].push_back(best);
+			adj[best].push_back(a);
+		}
+
+		// Hierholzer on the multigraph, then keep the first visit of every city.
+		vector<int> path, stack = {0};
+		vector<char> seen(n, 0);
+
+		while (!stack.empty())
+		{
+			int u = stack.back();
+			if (adj[u].empty())
+			{
+				stack.pop_back();
+				if (!seen[u])
+					seen[u] = 1, path.push_back(u);
+				continue;
+			}
+
+			int v = adj[u].back();
+			adj[u].pop_back();
+			adj[v].erase(find_if(adj[v].begin(), adj[v].end(), [&](int x) { return x == u; }));
+			stack.push_back(v);
+		}
+
+		return path;
+	}
+
+	static vector<int> build(const string& method, int start = 0)
+	{
+		/*
+			Objective:
+				Build a tour with the named method.
+
+			Parameters:
+				- method: "identity", "nn", "greedy", "sfc" or "christofides" (unknown names use "nn").
+				- start: First city for the nearest neighbor method.
+		*/
+
+		if (method == "identity")
+		{
+			vector<int> path(utilities::ctx().n_cities);
+			for (int i = 0; i < utilities::ctx().n_cities; i++)
+				path[i] = i;
+			return path;
+		}
+
+		if (method == "greedy")
+			return greedy_edge();
+
+		if (method == "sfc")
+			return space_filling_curve();
+
+		if (method == "christofides")
+			return christofides_lite();
+
+		return nearest_neighbor(start);
+	}
+};
@@ -1,6 +1,8 @@
 #pragma once
 #include "library.hpp"
 #include "ACO.hpp"
+#include "construction.hpp"
+#include "gpx.hpp"
 class gene
 {
 	/* 
@@ -17,7 +19,7 @@ class gene
 
 public:
 	int nodes;
-	LD fit = 0;
+	COST fit = 0;
 	vector<int> path, repath;
 	vector<bool> contain;
 
@@ -36,6 +38,28 @@ public:
 		contain.assign(n, 0);
 	}
 
+	void assign(vector<int> tour, const int& initial)
+	{
+		/*
+			Objective:
+				Set the gene to a given tour, rotated so that it starts at the initial city.
+			Parameters:
+				- tour: Tour over every city.
+				- initial: City that must come first (-1 keeps the tour as it is).
+		*/
+
+		if (initial != -1)
+			rotate(tour.begin(), find(tour.begin(), tour.end(), initial), tour.end());
+
+		path = tour;
+		for (int i = 0; i < nodes; i++)
+		{
+			repath[path[i]] = i;
+			contain[path[i]] = 1;
+		}
+		fit = utilities::Fx_fit(path, nodes, contain);
+	}
+
 	void bcr(gene& child, const gene& mother)
 	{
 		/* Best Cost Route crossover
@@ -55,24 +79,28 @@ public:
 			child = mother;
 			while (int(cut.size()) < nodes/2)
 			{
-				cut.insert(this->path[utilities::random_range((utilities::param.ga_p.fix_init == -1 ? 0 : utilities::param.ga_p.fix_init), nodes)]);
+				cut.insert(this->path[utilities::random_range((utilities::ctx().param.ga_p.fix_init == -1 ? 0 : utilities::ctx().param.ga_p.fix_init), nodes)]);
 			}
 		}
 		else
 		{
 			while (int(cut.size()) < nodes/2)
 			{
-				cut.insert(mother.path[utilities::random_range((utilities::param.ga_p.fix_init == -1 ? 0 : utilities::param.ga_p.fix_init), nodes)]);
+				cut.insert(mother.path[utilities::random_range((utilities::ctx().param.ga_p.fix_init == -1 ? 0 : utilities::ctx().param.ga_p.fix_init), nodes)]);
 			}
 		}
 		
 		for(auto e : cut)
 		{
+			// The child is a valid tour after every reinsertion, so a cancelled run keeps the partial result.
+			if (utilities::ctx().stop_token.stop_requested())
+				break;
+
 			new_path = child.path;
 			new_path.erase(new_path.begin() + child.repath[e]);
-			for(int i=(utilities::param.ga_p.fix_init == -1 ? 0 : 1); i<nodes; i++)
+			for(int i=(utilities::ctx().param.ga_p.fix_init == -1 ? 0 : 1); i<nodes; i++)
 			{
-				LD new_fit=INF;
+				COST new_fit=INF;
 				new_path.emplace(new_path.begin() + i, e);
 				new_fit = utilities::Fx_fit(new_path, nodes,child.contain);
 
@@ -91,6 +119,25 @@ public:
 		}
 	}
 
+	void gpx(gene& child, const gene& mother)
+	{
+		/* Generalized Partition Crossover
+			Objective:
+				Perform crossover using GPX; the child is the cheaper parent when the partitions give no improvement.
+			Parameters:
+				- child: Gene representing the child after crossover.
+				- mother: Gene representing the mother gene.
+		*/
+
+		vector<int> tour;
+		COST cost;
+
+		if (partition_crossover::merge(this->path, this->fit, mother.path, mother.fit, tour, cost))
+			child.assign(tour, utilities::ctx().param.ga_p.fix_init);
+		else
+			child = (this->fit <= mother.fit ? *this : mother);
+	}
+
 	void vr(gene& child, const vector<gene>& genes)
 	{	
 		/* Voting Recombination Crossover
@@ -103,18 +150,18 @@ public:
 
 		int i = 0;
 
-		if (utilities::param.ga_p.fix_init != -1)
+		if (utilities::ctx().param.ga_p.fix_init != -1)
 		{
 			i = 1;
-			child.insert(0, utilities::param.ga_p.fix_init); 
+			child.insert(0, utilities::ctx().param.ga_p.fix_init); 
 		}
 
 
 		for(; i<nodes; i++)
 		{
-			vector<int> aux(nodes+1, utilities::param.ga_p.P_limiar);
+			vector<int> aux(nodes+1, utilities::ctx().param.ga_p.P_limiar);
 			
-			for(int j=utilities::param.ga_p.P_value-1; j>-1; j--)
+			for(int j=utilities::ctx().param.ga_p.P_value-1; j>-1; j--)
 			{
 				aux[genes[j].path[i]]--;
 				if(!aux[genes[j].path[i]] && child.not_repeat_insert(i,genes[j].path[i]))
@@ -141,10 +188,10 @@ public:
 				- mother: Gene representing the mother gene.
 		*/
 
-		int father_gene = ((100 - utilities::param.ga_p.tx_mutation_AHCAVG) *  utilities::param.ga_p.alpha) / 100;
+		int father_gene = ((100 - utilities::ctx().param.ga_p.tx_mutation_AHCAVG) *  utilities::ctx().param.ga_p.alpha) / 100;
 		int rate = utilities::random_range(0, 100);
 
-		if (utilities::param.ga_p.fix_init != -1 or rate <= father_gene)
+		if (utilities::ctx().param.ga_p.fix_init != -1 or rate <= father_gene)
 		{
 			child.insert(0, this->path[0]);
 		}
@@ -286,7 +333,7 @@ public:
 				Update the path by simulating internal changes.
 		*/
 
-		for (int i = 0; i < utilities::param.ga_p.opt_path_swap_it; i++)
+		for (int i = 0; i < utilities::ctx().param.ga_p.opt_path_swap_it; i++)
 		{
 			utilities::opt_2s(path, fit, mutation);
 		}
@@ -311,7 +358,7 @@ public:
 
 		pmx(child, mother);
 	
-		if (utilities::random_range(0, 100)  < utilities::param.ga_p.cross_active[0])
+		if (utilities::random_range(0, 100)  < utilities::ctx().param.ga_p.cross_active[0])
 		{
 			bcr(child_save, mother);
 
@@ -321,7 +368,7 @@ public:
 			child_save = gene(nodes);
 		}
 
-		if (utilities::param.ga_p.cross_active[2])
+		if (utilities::ctx().param.ga_p.cross_active[2])
 		{
 			er(child_save, mother);
 
@@ -331,10 +378,20 @@ public:
 			child_save = gene(nodes);
 		}
 
-		if (utilities::param.ga_p.cross_active[3])
+		if (utilities::ctx().param.ga_p.cross_active[3])
 		{
 			vr(child_save, genes);
 
+			if (child_save.fit < child.fit)
+				child = child_save;
+
+			child_save = gene(nodes);
+		}
+
+		if (utilities::ctx().param.ga_p.cross_active[5] && utilities::random_range(0, 100) < utilities::ctx().param.ga_p.cross_active[5])
+		{
+			gpx(child_save, mother);
+
 			if (child_save.fit < child.fit)
 				child = child_save;
 		}
@@ -423,10 +480,63 @@ class genetic
 			Class with the objective of executing the heuristics algorithm.
 	*/
 
+	context& ctx;
 	int population;
 	int n_cities;
 	vector<gene> genes;
 	bool _active = false;
+	convergence_monitor monitor;
+
+	LD diversity()
+	{
+		/*
+			Objective:
+				Population diversity: fraction of the edges of the other genes that are not edges of the best gene.
+		*/
+
+		vector<int> next(n_cities), prev(n_cities);
+		LD shared = 0;
+
+		for (int i = 0; i < n_cities; i++)
+		{
+			next[genes[0].path[i]] = genes[0].path[(i + 1) % n_cities];
+			prev[genes[0].path[(i + 1) % n_cities]] = genes[0].path[i];
+		}
+
+		for (int g = 1; g < population; g++)
+		{
+			for (int i = 0; i < n_cities; i++)
+			{
+				int a = genes[g].path[i], b = genes[g].path[(i + 1) % n_cities];
+				shared += (next[a] == b || prev[a] == b);
+			}
+		}
+
+		return 1 - shared / ((LD)n_cities * max(1, population - 1));
+	}
+
+	void restart(const int& it)
+	{
+		/*
+			Objective:
+				Restart a stagnated population from its elite: the best gene is kept and every other gene becomes the best
+				tour perturbed by one to three double-bridge kicks.
+		*/
+
+		for (int i = 1; i < population; i++)
+		{
+			rng_scope child_stream(RNG_GA, it, 2 * population + i);
+			vector<int> tour = genes[0].path;
+
+			for (int k = 0; k <= i % 3; k++)
+				utilities::double_bridge(tour, utilities::rng());
+
+			genes[i].contain.assign(n_cities, 0);
+			genes[i].assign(tour, ctx.param.ga_p.fix_init);
+		}
+
+		sort(genes.begin(), genes.end(), order);
+	}
 
 	void calculate_relative_fit(vector<LD>& relative_fitness, LD& max_probability)
 	{
@@ -438,7 +548,7 @@ class genetic
 		LD max_fitness = INF;
 		max_probability = 0;
 
-		for (int i = 0; i < utilities::param.ga_p.max_population; i++)
+		for (int i = 0; i < ctx.param.ga_p.max_population; i++)
 		{
 			LD relative_fit = max_fitness - genes[i].fit;
 			relative_fitness.push_back(relative_fit);
@@ -461,7 +571,7 @@ class genetic
 		LD random_value = utilities::random_range_double(0, max_probability);
 		LD cumulative_probability = 0;
 
-		for (int i = 0; i < utilities::param.ga_p.max_population; i++)
+		for (int i = 0; i < ctx.param.ga_p.max_population; i++)
 		{
 			cumulative_probability += relative_fitness[i];
 			if (random_value <= cumulative_probability)
@@ -473,13 +583,13 @@ class genetic
 
 		if (father == -1)
 		{
-			father = utilities::random_range(0, utilities::param.ga_p.max_population);
+			father = utilities::random_range(0, ctx.param.ga_p.max_population);
 		}
 
 		random_value = utilities::random_range_double(0, max_probability);
 		cumulative_probability = 0;
 
-		for (int i = 0; i < utilities::param.ga_p.max_population; i++)
+		for (int i = 0; i < ctx.param.ga_p.max_population; i++)
 		{
 			cumulative_probability += relative_fitness[i];
 			if (random_value <= cumulative_probability)
@@ -491,11 +601,11 @@ class genetic
 
 		if (mother == -1)
 		{
-			mother = utilities::random_range(0, utilities::param.ga_p.max_population);
+			mother = utilities::random_range(0, ctx.param.ga_p.max_population);
 		}
 
 		while (mother == father)
-			mother = utilities::random_range(0, utilities::param.ga_p.max_population);
+			mother = utilities::random_range(0, ctx.param.ga_p.max_population);
 	}
 
 	void tournament_selection(int& father, int& mother)
@@ -510,7 +620,7 @@ class genetic
 
 		for (int i = 0; i < tournament_size; ++i)
 		{
-			tournament_contestants[i] = utilities::random_range(0, utilities::param.ga_p.max_population);
+			tournament_contestants[i] = utilities::random_range(0, ctx.param.ga_p.max_population);
 		}
 
 		int tournament_winner = tournament_contestants[0]; 
@@ -526,7 +636,7 @@ class genetic
 
 		for (int i = 0; i < tournament_size; ++i)
 		{
-			tournament_contestants[i] = utilities::random_range(0, utilities::param.ga_p.max_population);
+			tournament_contestants[i] = utilities::random_range(0, ctx.param.ga_p.max_population);
 		}
 
 		tournament_winner = tournament_contestants[0]; 
@@ -550,32 +660,50 @@ class genetic
 	
 		int it = 1;
 
-		while(it <= utilities::param.ga_p.max_generations)
+		while(it <= ctx.param.ga_p.max_generations)
 		{	
 			sort(genes.begin(), genes.end(), order);
-			
-			seed = std::chrono::system_clock::now().time_since_epoch().count();
-			gen = mt19937 (seed);
 
-			if(utilities::param.ga_p.verbose == 1 && it%10==0)
+			// Portfolio checkpoint: a better incumbent replaces the worst gene.
+			vector<int> shared_path = genes[0].path;
+			COST shared_fit = genes[0].fit;
+			if (utilities::share(shared_path, shared_fit))
+			{
+				genes[population - 1].assign(shared_path, ctx.param.ga_p.fix_init);
+				sort(genes.begin(), genes.end(), order);
+			}
+
+			if (utilities::should_stop(genes[0].fit))
+				break;
+
+			monitor_action action = monitor.observe(genes[0].fit, (ctx.param.min_diversity > 0 ? diversity() : 1));
+			if (action == MONITOR_STOP)
+				break;
+			if (action == MONITOR_RESTART)
+				restart(it);
+
+			if(ctx.param.ga_p.verbose == 1 && it%10==0)
 				print_verbose(it/10);
 
 			vector<gene> new_generation(population, gene(n_cities));
 
-			for (int i = 0; i <  utilities::param.ga_p.tx_elite; i++)
+			// Every child draws from the stream keyed by (seed, generation, child), independent of evaluation order.
+			for (int i = 0; i <  ctx.param.ga_p.tx_elite; i++)
 			{
+				rng_scope child_stream(RNG_GA, it, i);
 				new_generation[i] = genes[i];
 				new_generation[i].mutation_swap(false);
 			}
 
-			for (int i =  utilities::param.ga_p.tx_elite; i < population; i++)
+			for (int i =  ctx.param.ga_p.tx_elite; i < population; i++)
 			{
+				rng_scope child_stream(RNG_GA, it, i);
 				int father = -1, mother = -1;
 				
-				if(utilities::param.ga_p.balance > 0)
+				if(ctx.param.ga_p.balance > 0)
 				{
-					father = utilities::random_range(0,  population /  utilities::param.ga_p.balance);
-					mother = utilities::random_range(0, population /  utilities::param.ga_p.balance);
+					father = utilities::random_range(0,  population /  ctx.param.ga_p.balance);
+					mother = utilities::random_range(0, population /  ctx.param.ga_p.balance);
 				}
 				else
 				{
@@ -588,9 +716,11 @@ class genetic
 				new_generation[i] = genes[father].cross(genes[mother], genes);
 			}
 
-			for(int i=utilities::param.ga_p.tx_elite; i<population; i++)
+			// Mutations are optional, so they are cut short when the run is cancelled.
+			for(int i=ctx.param.ga_p.tx_elite; i<population && !ctx.stop_token.stop_requested(); i++)
 			{
-				if(utilities::random_range(0, 100) < utilities::param.ga_p.opt_range)
+				rng_scope child_stream(RNG_GA, it, population + i);
+				if(utilities::random_range(0, 100) < ctx.param.ga_p.opt_range)
 				{
 					if(utilities::random_range()%2 == 0)
 						utilities::opt_2s(new_generation[i].path, new_generation[i].fit, true);
@@ -612,15 +742,31 @@ class genetic
 	{
 		/*
 			Objective:
-				Function to initialize the gene vector with allowed paths.
+				Function to initialize the gene vector with allowed paths: the first genes come from the elite pool (which
+				holds the construction tour; without a pool the construction tour alone seeds it), a share of the population
+				from nearest neighbor tours with random start cities, and the rest is random.
 		*/
 
+		int seeded = population * ctx.param.ga_p.seeded / 100;
+		vector<pair<COST, vector<int>>> elites = ctx.elites.tours();
+
+		if (elites.empty() && ctx.param.init != "identity")
+		{
+			rng_scope seed_stream(RNG_GA, 0, 0);
+			elites.push_back({INF, construction::build(ctx.param.init)});
+		}
+
 		for (int i = 0; i < population; i++)
 		{
-			if (utilities::param.ga_p.fix_init == -1)
-				utilities::random_path(utilities::random_range(0, utilities::n_cities), 0, genes[i].fit, genes[i].path, genes[i].repath, genes[i].contain);			
+			rng_scope child_stream(RNG_GA, 0, i);
+			if (i < (int)elites.size())
+				genes[i].assign(elites[i].second, ctx.param.ga_p.fix_init);
+			else if (i < seeded)
+				genes[i].assign(construction::nearest_neighbor(utilities::random_range(0, n_cities)), ctx.param.ga_p.fix_init);
+			else if (ctx.param.ga_p.fix_init == -1)
+				utilities::random_path(utilities::random_range(0, ctx.n_cities), 0, genes[i].fit, genes[i].path, genes[i].repath, genes[i].contain);			
 			else
-				utilities::random_path(utilities::param.ga_p.fix_init, 0, genes[i].fit, genes[i].path, genes[i].repath, genes[i].contain);	
+				utilities::random_path(ctx.param.ga_p.fix_init, 0, genes[i].fit, genes[i].path, genes[i].repath, genes[i].contain);	
 		}
 	}
 	
@@ -633,8 +779,10 @@ class genetic
 
 		cout << "Generation " << x << ":\n";
 		cout << "Best: " << genes[0].fit << " cust\n";
+		if (ctx.lower_bound > 0)
+			cout << "Gap: " << utilities::gap(genes[0].fit) << "%\n";
 		
-		if ( utilities::param.ga_p.simple_verbose == 0)
+		if ( ctx.param.ga_p.simple_verbose == 0)
 		{
 			cout << "Current Population: \n";
 			for (auto e : genes)
@@ -643,7 +791,7 @@ class genetic
 				cout << "Path: ";
 				for (int i = 0; i < n_cities; i++)
 				{
-					cout << e.path[i];
+					cout << utilities::original(e.path[i]);
 					if (i + 1 < n_cities)
 					{
 						cout << " ";
@@ -655,19 +803,21 @@ class genetic
 	}
 
 public:
-	genetic(int number_of_cities) 
+	genetic(context& instance) : ctx(instance)
 	{
 		/*
 			Objective:
 				Genetic class constructor.
+			Parameters:
+				- instance: Context of the solve.
 		*/
 
-		n_cities = number_of_cities;
-		population =  utilities::param.ga_p.max_population;
+		n_cities = ctx.n_cities;
+		population =  ctx.param.ga_p.max_population;
 		genes.assign(population,gene(n_cities));
 	}
 
-	LD best_fit()
+	COST best_fit()
 	{
 		/*
 			Objective:
@@ -714,17 +864,23 @@ public:
 		return genes[0].path;
 	}
 
-	LD activate()
+	COST activate()
 	{
 		/*
 			Objective:
 				Function with the aim of activating the genetic algorithm.
 		*/
 
+		context_scope scope(ctx);
+		rng_scope stream(RNG_GA);
 		init();
 		simulation();
 		sort(genes.begin(), genes.end(), order);
 		_active = true;
+
+		for (auto& g : genes)
+			ctx.elites.offer(g.path, g.fit);
+
 		return genes[0].fit;
 	}
 };
\ No newline at end of file
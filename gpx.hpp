@@ -0,0 +1,156 @@
+#pragma once
+#include "library.hpp"
+
+class partition_crossover
+{
+	/*
+		Objective:
+			Generalized Partition Crossover (GPX). The edges shared by two parent tours are kept; removing them leaves
+			the edges found in only one parent, whose connected components split the cities into partitions. A
+			component entered through exactly two shared edges is crossed by both parents as a single path between the
+			same two cities, so either parent's path can be used there independently of the other components. The child
+			takes the cheaper parent everywhere, except in those components where the other parent's path is shorter.
+			Runs in linear time (up to the union-find).
+	*/
+
+	static int find(vector<int>& parent, int x)
+	{
+		while (parent[x] != x)
+			x = parent[x] = parent[parent[x]];
+		return x;
+	}
+
+public:
+	static bool merge(const vector<int>& a, const COST& cost_a, const vector<int>& b, const COST& cost_b, vector<int>& child, COST& child_cost)
+	{
+		/*
+			Objective:
+				Cross two tours with GPX.
+
+			Parameters:
+				- a, b: Parent tours and cost_a, cost_b their costs.
+				- child: Receives the child tour.
+				- child_cost: Receives its cost.
+
+			Returns:
+				Whether the child is cheaper than both parents (child is only written in that case).
+		*/
+
+		int n = a.size();
+		if (n < 4 || (int)b.size() != n)
+			return false;
+
+		const vector<int>& base = (cost_a <= cost_b ? a : b);
+		const vector<int>& other = (cost_a <= cost_b ? b : a);
+
+		vector<int> base_next(n), base_prev(n), other_next(n), other_prev(n);
+		for (int i = 0; i < n; i++)
+		{
+			int j = (i + 1 == n ? 0 : i + 1);
+			base_next[base[i]] = base[j], base_prev[base[j]] = base[i];
+			other_next[other[i]] = other[j], other_prev[other[j]] = other[i];
+		}
+
+		// Components of the edges found in only one parent; cities whose two edges are shared belong to none.
+		vector<int> parent(n);
+		vector<char> in_component(n, 0);
+		for (int i = 0; i < n; i++)
+			parent[i] = i;
+
+		for (int u = 0; u < n; u++)
+		{
+			int v = base_next[u];
+			if (other_next[u] != v && other_prev[u] != v)
+			{
+				parent[find(parent, u)] = find(parent, v);
+				in_component[u] = in_component[v] = 1;
+			}
+
+			v = other_next[u];
+			if (base_next[u] != v && base_prev[u] != v)
+			{
+				parent[find(parent, u)] = find(parent, v);
+				in_component[u] = in_component[v] = 1;
+			}
+		}
+
+		// Shared edges leaving every component, and how much shorter the other parent is inside it.
+		vector<int> portals(n, 0);
+		vector<LD> gain(n, 0);
+
+		for (int u = 0; u < n; u++)
+		{
+			int v = base_next[u];
+			int ru = (in_component[u] ? find(parent, u) : -1), rv = (in_component[v] ? find(parent, v) : -1);
+			bool shared = (other_next[u] == v || other_prev[u] == v);
+
+			if (shared && ru != rv)
+			{
+				if (ru != -1)
+					portals[ru]++;
+				if (rv != -1)
+					portals[rv]++;
+			}
+			else if (!shared)
+				gain[ru] += (LD)utilities::distance(u, v);
+
+			v = other_next[u];
+			if (base_next[u] != v && base_prev[u] != v)
+				gain[find(parent, u)] -= (LD)utilities::distance(u, v);
+		}
+
+		vector<char> use_other(n, 0);
+		bool any = false;
+		for (int r = 0; r < n; r++)
+		{
+			use_other[r] = (in_component[r] && find(parent, r) == r && portals[r] == 2 && gain[r] > 1e-9);
+			any |= use_other[r];
+		}
+
+		if (!any)
+			return false;
+
+		// Child edges: the base parent's edges outside the chosen components and the other parent's inside them.
+		vector<array<int, 2>> adj(n, {-1, -1});
+		auto link = [&](int u, int v)
+		{
+			adj[u][adj[u][0] != -1] = v;
+			adj[v][adj[v][0] != -1] = u;
+		};
+
+		for (int u = 0; u < n; u++)
+		{
+			int v = base_next[u];
+			bool shared = (other_next[u] == v || other_prev[u] == v);
+			if (shared || !use_other[find(parent, u)])
+				link(u, v);
+
+			v = other_next[u];
+			if (base_next[u] != v && base_prev[u] != v && use_other[find(parent, u)])
+				link(u, v);
+		}
+
+		vector<int> tour;
+		tour.reserve(n);
+		for (int prev = -1, current = base[0]; (int)tour.size() < n;)
+		{
+			tour.push_back(current);
+			int next = (adj[current][0] != prev ? adj[current][0] : adj[current][1]);
+			prev = current;
+			current = next;
+			if (current == base[0] || current == -1)
+				break;
+		}
+
+		if ((int)tour.size() != n)
+			return false;
+
+		COST cost = utilities::Fx_fit(tour, n);
+		if (cost >= min(cost_a, cost_b))
+			return false;
+
+		child = tour;
+		child_cost = cost;
+		return true;
+	}
+};
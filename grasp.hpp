@@ -8,6 +8,7 @@ class grasp
             Class implementing the GRASP (Greedy Randomized Adaptive Search Procedure) algorithm for solving optimization problems.
 
         Attributes:
+            ctx: Context of the solve.
             l: Number of iterations.
             m: Number of alpha parameters.
             cont_alpha: Counter for each alpha parameter.
@@ -21,6 +22,7 @@ class grasp
 
 public:
 
+    context& ctx;
     int l;
     int m;
     vector<int> cont_alpha;
@@ -29,28 +31,29 @@ public:
     vector<double> alpha;
     int beta;
     vector<int> best_solution;
-    LD best_cost;
+    COST best_cost;
 
-    grasp(vector<int> s_initial, LD s_cost_initial) 
+    grasp(context& instance, vector<int> s_initial, COST s_cost_initial) : ctx(instance)
     {
         /*
             Objective:
                 Constructor for initializing the grasp algorithm.
 
             Parameters:
+                instance: Context of the solve.
                 s_initial: Initial solution.
                 s_cost_initial: Initial solution cost.
         */
 
         best_solution = s_initial;
         best_cost = s_cost_initial;
-        m = utilities::param.grasp_p.m;
+        m = ctx.param.grasp_p.m;
         p_alpha = vector<double>(m, 1.0 / m);
         cont_alpha = vector<int>(m, 0);
         solution_alpha = vector<double>(m, 1.0 / m);
-        alpha = utilities::param.grasp_p.alpha;
-        beta = utilities::param.grasp_p.beta;
-        l = utilities::param.grasp_p.l;
+        alpha = ctx.param.grasp_p.alpha;
+        beta = ctx.param.grasp_p.beta;
+        l = ctx.param.grasp_p.l;
     }
 
     vector<int> greedyRandomizedConstruction(double alpha) 
@@ -67,11 +70,11 @@ public:
         */
 
         vector<int> solution;
-        vector<point> candidate_list = utilities::city;
+        vector<point> candidate_list = ctx.city;
         vector<int> candidate_Position;
         vector<LD> candidate_dist;
 
-        for (int i = 0; i < utilities::n_cities; i++)
+        for (int i = 0; i < ctx.n_cities; i++)
             candidate_Position.push_back(i);
 
         int index = utilities::random_range(0, candidate_list.size());
@@ -88,7 +91,7 @@ public:
 
             for (int k = 0; k < m; k++) 
             {
-                double d = utilities::euclidian_distance(utilities::city[solution.back()], candidate_list[k]);
+                double d = utilities::distance(solution.back(), candidate_Position[k]);
                 candidate_dist.push_back(d);
                 d_min = min(d_min, d);
                 d_max = max(d_max, d);
@@ -121,39 +124,34 @@ public:
     {
         /*
             Objective:
-                Perform local search on the given solution.
+                Perform local search on the given solution: first-improvement exchanges of two cities, each scored
+                with its exact cost delta instead of a full tour evaluation.
 
             Parameters:
                 solution_local: Solution to apply local search on.
         */
 
-        int n_cities = utilities::n_cities;
+        int n_cities = ctx.n_cities;
         bool improved = true;
-        double local_Cost = utilities::Fx_fit(solution_local, n_cities);
 
-        while (improved) 
+        while (improved && !ctx.stop_token.stop_requested()) 
         {
             improved = false;
 
-            for (int i = 1; i < n_cities - 1; ++i) 
+            for (int i = 1; i < n_cities - 1 && !ctx.stop_token.stop_requested(); ++i) 
             {
                 for (int j = i + 1; j < n_cities; ++j) 
                 {
-                    swap(solution_local[i], solution_local[j]);
-                    double newCost = utilities::Fx_fit(solution_local, n_cities);
-
-                    if (newCost < local_Cost) 
-                    {
-                        local_Cost = newCost;
-                        improved = true;
-                    } 
-                    else 
+                    if (utilities::exchange_delta(solution_local, i, j) < -COST_EPS) 
                     {
                         swap(solution_local[i], solution_local[j]);
+                        improved = true;
                     }
                 }
             }
         }
+
+        COST local_Cost = utilities::Fx_fit(solution_local, n_cities);
         if (best_cost > local_Cost) 
         {
             best_solution = solution_local;
@@ -224,7 +222,7 @@ public:
         return m - 1;
     }
 
-    LD solution() 
+    COST solution() 
     {
         /*
             Objective:
@@ -233,9 +231,13 @@ public:
             Returns:
                 Best cost found by the algorithm.
         */
-       
-        for (int i = 0; i < l; i++) 
+
+        context_scope scope(ctx);
+        convergence_monitor monitor;
+
+        for (int i = 0; i < l && !utilities::should_stop(best_cost); i++) 
         {
+            rng_scope stream(RNG_GRASP, i);
             int index = select_alpha();
 
             cont_alpha[index]++;
@@ -243,14 +245,31 @@ public:
 
             local_Search(solution);
             
-            if(utilities::param.grasp_p.verbose)
+            if(ctx.param.grasp_p.verbose)
+            {
                 cout << endl << i << ": " << best_cost << endl;
+                if (ctx.lower_bound > 0)
+                    cout << "Gap: " << utilities::gap(best_cost) << "%" << endl;
+            }
 
             solution_alpha[index] += best_cost;
+            utilities::share(best_solution, best_cost);
+
+            // Every iteration already restarts the construction, so a restart forgets the learned alpha probabilities.
+            monitor_action action = monitor.observe(best_cost);
+            if (action == MONITOR_STOP)
+                break;
+            if (action == MONITOR_RESTART)
+            {
+                p_alpha.assign(m, 1.0 / m);
+                cont_alpha.assign(m, 0);
+                solution_alpha.assign(m, 1.0 / m);
+            }
 
             update_probability(i);
         }
 
+        ctx.elites.offer(best_solution, best_cost);
         return best_cost;
     }
 };
\ No newline at end of file
@@ -0,0 +1,458 @@
+#pragma once
+#include "library.hpp"
+
+class ils
+{
+    /*
+        Objective:
+            Iterated Local Search: alternates double-bridge kicks with a 2-opt/Or-opt local search over candidate lists.
+            The local search keeps a queue of active cities (don't-look bits): after a kick only the endpoints of the
+            changed edges are re-checked, and every improving move re-activates the endpoints of the edges it changed.
+            The tour cost follows the kick and move deltas, and a rejected kick is undone from a journal of the changed
+            positions, so an iteration costs time in proportion to the changes rather than to n.
+
+        Attributes:
+            ctx: Context of the solve.
+            n: Number of cities.
+            k: Candidates per city.
+            tour, pos: Working tour and the position of every city in it.
+            tour_cost: Cost of the working tour, maintained from the deltas.
+            journal: Positions written since the last accepted tour and the city each one held, to undo a rejected kick.
+            neighbors: Flat candidate lists (alpha-nearest when the lower bound computed them, nearest otherwise).
+            active, queue: Don't-look bits and the queue of cities to check.
+            cs, ds, deltas: Scratch buffers of the batched move evaluation.
+            best_solution: Best tour found.
+            best_cost: Cost of the best tour found.
+    */
+
+    context& ctx;
+    int n;
+    int k;
+    vector<int> tour, pos;
+    COST tour_cost;
+    vector<pair<int, int>> journal;
+    vector<int> neighbors;
+    vector<char> active;
+    deque<int> queue;
+    vector<int> cs, ds, segment, window;
+    vector<COST> deltas;
+
+    int succ(const int& c)
+    {
+        return tour[pos[c] + 1 == n ? 0 : pos[c] + 1];
+    }
+
+    int pred(const int& c)
+    {
+        return tour[pos[c] == 0 ? n - 1 : pos[c] - 1];
+    }
+
+    void place(const int& i, const int& c)
+    {
+        journal.push_back({i, tour[i]});
+        tour[i] = c;
+        pos[c] = i;
+    }
+
+    void undo()
+    {
+        /*
+            Objective:
+                Restore the last accepted tour by replaying the journal backwards.
+        */
+
+        for (int i = (int)journal.size() - 1; i >= 0; i--)
+        {
+            tour[journal[i].first] = journal[i].second;
+            pos[journal[i].second] = journal[i].first;
+        }
+        journal.clear();
+    }
+
+    void activate(const int& c)
+    {
+        if (!active[c])
+        {
+            active[c] = 1;
+            queue.push_back(c);
+        }
+    }
+
+    void reverse_path(int from, int to)
+    {
+        /*
+            Objective:
+                Reverse the cities at positions from..to (cyclic); the complement is reversed instead when it is
+                shorter, which gives the same tour.
+        */
+
+        int len = (to - from + n) % n + 1;
+        if (2 * len > n)
+        {
+            int start = (to + 1) % n;
+            to = (from - 1 + n) % n;
+            from = start;
+            len = n - len;
+        }
+
+        for (int s = 0; s < len / 2; s++)
+        {
+            int a = tour[from], b = tour[to];
+            place(from, b);
+            place(to, a);
+            from = (from + 1 == n ? 0 : from + 1);
+            to = (to == 0 ? n - 1 : to - 1);
+        }
+    }
+
+    void move_segment(const int& a, const int& len, const int& u, const int& v, const bool& reversed)
+    {
+        /*
+            Objective:
+                Move the segment of len cities starting at a between the adjacent cities u and v = succ(u), rewriting
+                only the shorter of the two windows that contain the segment and the insertion point.
+        */
+
+        int start = pos[a], last = (start + len - 1) % n;
+        int forward = (pos[u] - last + n) % n, backward = (start - pos[v] + n) % n;
+
+        segment.clear();
+        for (int i = 0; i < len; i++)
+            segment.push_back(tour[(start + i) % n]);
+        if (reversed)
+            std::reverse(segment.begin(), segment.end());
+
+        window.clear();
+        if (forward <= backward)
+        {
+            // S, next..u  ->  next..u, S'
+            for (int i = 1; i <= forward; i++)
+                window.push_back(tour[(last + i) % n]);
+            window.insert(window.end(), segment.begin(), segment.end());
+        }
+        else
+        {
+            // v..prev, S  ->  S', v..prev
+            window = segment;
+            for (int i = 0; i < backward; i++)
+                window.push_back(tour[(pos[v] + i) % n]);
+            start = pos[v];
+        }
+
+        for (int i = 0; i < (int)window.size(); i++)
+            place((start + i) % n, window[i]);
+    }
+
+    bool two_opt(const int& a)
+    {
+        /*
+            Objective:
+                Best improving 2-opt move that adds an edge between a and one of its candidates, in both tour directions.
+        */
+
+        for (int dir = 0; dir < 2; dir++)
+        {
+            int b = (dir ? pred(a) : succ(a)), m = 0;
+
+            for (int t = 0; t < k; t++)
+            {
+                int c = neighbors[a * k + t], d = (dir ? pred(c) : succ(c));
+                if (c == b || d == a)
+                    continue;
+                cs[m] = c, ds[m] = d, m++;
+            }
+
+            utilities::pair_deltas(a, b, cs.data(), ds.data(), m, -utilities::distance(a, b), deltas.data());
+
+            int best = -1;
+            COST best_delta = -COST_EPS;
+            for (int t = 0; t < m; t++)
+                if (deltas[t] < best_delta)
+                    best_delta = deltas[t], best = t;
+
+            if (best == -1)
+                continue;
+
+            int c = cs[best], d = ds[best];
+
+            // a b ... c d -> a c ... b d (forward), d c ... b a -> d b ... c a (backward).
+            if (!dir)
+                reverse_path(pos[b], pos[c]);
+            else
+                reverse_path(pos[c], pos[b]);
+
+            tour_cost += best_delta;
+            activate(a), activate(b), activate(c), activate(d);
+            return true;
+        }
+
+        return false;
+    }
+
+    bool or_opt(const int& a)
+    {
+        /*
+            Objective:
+                Best improving Or-opt move of the segment of 1 to 3 cities starting at a, inserted next to one of the
+                candidates of a: between c and succ(c) in order, or between pred(c) and c reversed.
+        */
+
+        for (int len = 1; len <= 3 && len + 3 <= n; len++)
+        {
+            int e = a;
+            for (int i = 1; i < len; i++)
+                e = succ(e);
+
+            int p = pred(a), next = succ(e);
+            COST base = utilities::distance(p, next) - utilities::distance(p, a) - utilities::distance(e, next);
+
+            for (int dir = 0; dir < 2; dir++)
+            {
+                int m = 0;
+
+                for (int t = 0; t < k; t++)
+                {
+                    int c = neighbors[a * k + t], d = (dir ? pred(c) : succ(c));
+                    if ((pos[c] - pos[a] + n) % n < len || (pos[d] - pos[a] + n) % n < len)
+                        continue;
+                    cs[m] = c, ds[m] = d, m++;
+                }
+
+                utilities::pair_deltas(a, e, cs.data(), ds.data(), m, base, deltas.data());
+
+                int best = -1;
+                COST best_delta = -COST_EPS;
+                for (int t = 0; t < m; t++)
+                    if (deltas[t] < best_delta)
+                        best_delta = deltas[t], best = t;
+
+                if (best == -1)
+                    continue;
+
+                int c = cs[best], d = ds[best];
+
+                if (!dir)
+                    move_segment(a, len, c, d, false);
+                else
+                    move_segment(a, len, d, c, true);
+
+                tour_cost += best_delta;
+                activate(a), activate(e), activate(p), activate(next), activate(c), activate(d);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void local_search()
+    {
+        /*
+            Objective:
+                Improve the working tour until no active city has an improving move.
+        */
+
+        while (!queue.empty())
+        {
+            int a = queue.front();
+            queue.pop_front();
+            active[a] = 0;
+
+            if (two_opt(a) || (ctx.param.ils_p.or_opt && or_opt(a)))
+                activate(a);
+        }
+    }
+
+    void kick(philox& rng)
+    {
+        /*
+            Objective:
+                Segment double-bridge: after a random position s, the two consecutive segments B and C that fit in the
+                kick window swap places (A B C D -> A C B D), and the six endpoints of the changed edges become active.
+        */
+
+        if (n < 8)
+            return;
+
+        int w = ctx.param.ils_p.kick_window;
+        w = (w <= 0 || w > n - 1 ? n - 1 : max(w, 3));
+
+        int s = rng.bounded(n);
+        int x = 1 + rng.bounded(w - 1);
+        int y = x + 1 + rng.bounded(w - x);
+
+        int a = tour[s], b0 = tour[(s + 1) % n], b1 = tour[(s + x) % n];
+        int c0 = tour[(s + x + 1) % n], c1 = tour[(s + y) % n], d0 = tour[(s + y + 1) % n];
+
+        tour_cost += utilities::distance(a, c0) + utilities::distance(c1, b0) + utilities::distance(b1, d0)
+            - utilities::distance(a, b0) - utilities::distance(b1, c0) - utilities::distance(c1, d0);
+
+        window.clear();
+        for (int i = x + 1; i <= y; i++)
+            window.push_back(tour[(s + i) % n]);
+        for (int i = 1; i <= x; i++)
+            window.push_back(tour[(s + i) % n]);
+
+        for (int i = 0; i < (int)window.size(); i++)
+            place((s + 1 + i) % n, window[i]);
+
+        activate(a), activate(b0), activate(b1), activate(c0), activate(c1), activate(d0);
+    }
+
+    bool accept(const COST& cost, const COST& current_cost, const int& it, philox& rng)
+    {
+        /*
+            Objective:
+                Acceptance criterion of the tour found after a kick: "better" (not worse than the current tour),
+                "walk" (always), "threshold" (within ils.threshold percent of the best) or "anneal" (Metropolis rule
+                with a temperature falling linearly from ils.temperature to zero).
+        */
+
+        const string& rule = ctx.param.ils_p.acceptance;
+
+        if (cost <= current_cost || rule == "walk")
+            return true;
+
+        if (rule == "threshold")
+            return (LD)cost <= (LD)best_cost * (1 + ctx.param.ils_p.threshold / 100);
+
+        if (rule == "anneal")
+        {
+            LD t = ctx.param.ils_p.temperature * (1 - (LD)it / max(1, ctx.param.ils_p.iterations));
+            return t > 0 && rng.real() < exp(-((LD)cost - current_cost) / t);
+        }
+
+        return false;
+    }
+
+    void load(const vector<int>& path)
+    {
+        /*
+            Objective:
+                Make a path the working tour, with every city active.
+        */
+
+        tour = path;
+        tour_cost = utilities::Fx_fit(tour, n);
+        journal.clear();
+        for (int i = 0; i < n; i++)
+        {
+            pos[tour[i]] = i;
+            activate(tour[i]);
+        }
+    }
+
+    void improve()
+    {
+        /*
+            Objective:
+                Keep the working tour as the best one when its running cost beats it, re-measured exactly.
+        */
+
+        if (tour_cost >= best_cost - COST_EPS)
+            return;
+
+        tour_cost = utilities::Fx_fit(tour, n);
+        if (tour_cost < best_cost)
+            best_solution = tour, best_cost = tour_cost;
+    }
+
+public:
+    vector<int> best_solution;
+    COST best_cost;
+
+    ils(context& instance, vector<int> s_initial, COST s_cost_initial) : ctx(instance)
+    {
+        /*
+            Objective:
+                Constructor for initializing the ILS algorithm.
+
+            Parameters:
+                instance: Context of the solve.
+                s_initial: Initial solution.
+                s_cost_initial: Initial solution cost.
+        */
+
+        n = ctx.n_cities;
+        k = max(0, min(ctx.param.ils_p.candidates, n - 1));
+        best_solution = s_initial;
+        best_cost = s_cost_initial;
+    }
+
+    COST solution()
+    {
+        /*
+            Objective:
+                Execute the ILS algorithm.
+
+            Returns:
+                Best cost found by the algorithm.
+        */
+
+        context_scope scope(ctx);
+        rng_scope stream(RNG_ILS);
+        convergence_monitor monitor;
+
+        if (n < 5)
+            return best_cost;
+
+        neighbors = utilities::candidate_lists(k);
+        pos.assign(n, 0);
+        active.assign(n, 0);
+        cs.assign(k, 0), ds.assign(k, 0), deltas.assign(k, 0);
+
+        load(best_solution);
+        local_search();
+        improve();
+        journal.clear();
+
+        COST current_cost = tour_cost;
+
+        for (int it = 0; it < ctx.param.ils_p.iterations && !utilities::should_stop(best_cost); it++)
+        {
+            kick(utilities::rng());
+            local_search();
+            improve();
+
+            if (accept(tour_cost, current_cost, it, utilities::rng()))
+                journal.clear(), current_cost = tour_cost;
+            else
+                undo(), tour_cost = current_cost;
+
+            // Portfolio checkpoint: continue from the incumbent when another solver found a better tour.
+            if (utilities::share(best_solution, best_cost))
+            {
+                load(best_solution);
+                local_search();
+                improve();
+                journal.clear();
+                current_cost = tour_cost;
+            }
+
+            // Stagnation: continue from the best tour kicked three times, or stop.
+            monitor_action action = monitor.observe(best_cost);
+            if (action == MONITOR_STOP)
+                break;
+            if (action == MONITOR_RESTART)
+            {
+                load(best_solution);
+                for (int j = 0; j < 3; j++)
+                    kick(utilities::rng());
+                local_search();
+                improve();
+                journal.clear();
+                current_cost = tour_cost;
+            }
+
+            if (ctx.param.ils_p.verbose)
+            {
+                cout << endl << it << ": " << best_cost << endl;
+                if (ctx.lower_bound > 0)
+                    cout << "Gap: " << utilities::gap(best_cost) << "%" << endl;
+            }
+        }
+
+        ctx.elites.offer(best_solution, best_cost);
+        return best_cost;
+    }
+};
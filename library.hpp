@@ -4,30 +4,159 @@
 #include <time.h>
 #include <random>
 #include <fstream>
+#include <filesystem>
 #include <cstdlib>
 #include <unordered_map>
 #include <chrono>
 #include <limits.h>
 #include <algorithm>
 #include <vector>
+#include <deque>
+#include <array>
 #include <set>
 #include <unordered_set>
 #include <math.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <type_traits>
+#include "simd.hpp"
 
 #define PARAMS_FILE "params.txt"
-#define BEST_PARAMS_FILE "best_params.txt"
 #define INPUT_FILE "input.txt"
 #define unormap unordered_map
 #define endl "\n"
 #define LL long long
 #define ULL unsigned long long
-#define LD long double
 #define INF 1e16
 
+// Precision policy: COST is the type of distances and tour costs (float, double, long double, or long long
+// for TSPLIB integer distances); LD is the real type of coordinates, probabilities, temperatures and metrics.
+#ifndef COST_TYPE
+#define COST_TYPE double
+#endif
+#ifndef REAL_TYPE
+#define REAL_TYPE double
+#endif
+#define COST COST_TYPE
+#define LD REAL_TYPE
+
+// Smallest cost change counted as an improvement: zero for integer costs, a rounding tolerance for real ones.
+#define COST_EPS ((COST)1e-7)
+
 using namespace std;
 
-unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-mt19937 gen(seed);
+// Side of the grid the coordinates are snapped to before computing Hilbert curve positions.
+#define HILBERT_GRID 65536u
+#define GREEDY_CANDIDATES 10
+
+// Instances up to this size keep integer distances in a flat n x n int32 store, larger ones compute them on demand.
+#define DIST_STORE_LIMIT 10000
+
+enum distance_type
+{
+	/*
+		Objective:
+			Distance function of an instance: real Euclidean, or one of the TSPLIB integer functions.
+	*/
+
+	DIST_EUC,
+	DIST_EUC_2D,
+	DIST_CEIL_2D,
+	DIST_ATT,
+	DIST_GEO
+};
+
+distance_type distance_type_from(const string& name)
+{
+	/*
+		Objective:
+			Map a TSPLIB EDGE_WEIGHT_TYPE name to a distance_type (unknown names keep the real Euclidean distance).
+	*/
+
+	if (name == "EUC_2D")
+		return DIST_EUC_2D;
+	if (name == "CEIL_2D")
+		return DIST_CEIL_2D;
+	if (name == "ATT")
+		return DIST_ATT;
+	if (name == "GEO")
+		return DIST_GEO;
+
+	return DIST_EUC;
+}
+
+struct bound_params
+{
+	/*
+        Objective:
+            A struct responsible for storing parameters for the Held-Karp lower bound.
+
+        Attributes:
+            active - Whether the bound is computed before the stages run.
+            iterations - Maximum number of subgradient iterations.
+            period - Iterations without improvement before the subgradient step is halved.
+            target_gap - Gap to the bound (in percent) at which stages and the pipeline stop (0 disables it).
+            candidates - Size of the alpha-nearness candidate lists (0 disables them).
+    */
+
+	bool active;
+	int iterations;
+	int period;
+	LD target_gap;
+	int candidates;
+
+	bound_params()
+	{
+		/*
+            Objective:
+                Default constructor initializing parameters with default values.
+        */
+
+		active = false;
+		iterations = 300;
+		period = 20;
+		target_gap = 0;
+		candidates = 8;
+	}
+};
+
+struct benchmark_params
+{
+	/*
+        Objective:
+            A struct responsible for storing parameters for the benchmark mode.
+
+        Attributes:
+            active - Whether the run is replaced by a benchmark of repeated runs.
+            runs - Number of independent runs, seeded seed, seed + 1, ...
+            target - Cost whose first time of reach is measured (0 uses the predicted value of the input).
+            output - Prefix of the result files (prefix_runs.csv and prefix_summary.csv).
+    */
+
+	bool active;
+	int runs;
+	LD target;
+	string output;
+
+	benchmark_params()
+	{
+		/*
+            Objective:
+                Default constructor initializing parameters with default values.
+        */
+
+		active = false;
+		runs = 10;
+		target = 0;
+		output = "benchmark";
+	}
+};
 
 struct ABC_params 
 {
@@ -42,6 +171,7 @@ struct ABC_params
             scout_percent: Percentage of scouts.
             onlooker_percent: Percentage of onlooker bees.
             employed_percent: Percentage of employed bees.
+            selection_pressure: Exponent applied to best/cost when onlookers choose a food source.
 			verbose = Defines whether to activate the verbose.
     */
 
@@ -51,6 +181,7 @@ struct ABC_params
     double scout_percent;
     double onlooker_percent;
     double employed_percent;
+    LD selection_pressure;
 	bool verbose;
 
     ABC_params() 
@@ -65,6 +196,7 @@ struct ABC_params
         scout_percent = 0.4;
         onlooker_percent = 0.2;
         employed_percent = 0.8;
+        selection_pressure = 8;
 		verbose = 0;
     }
 };
@@ -85,6 +217,11 @@ struct ACO_params
             max_opt_it: Maximum number of optimization iterations.
             local_search: Indicates whether local search should be performed.
             verbose: Indicates whether verbose output should be enabled.
+            candidates: Number of candidate cities (alpha-nearest or nearest) an ant may choose from at each step (0 considers every city).
+            mmas: Enables the MAX-MIN Ant System pheromone model (decay is then the proportional evaporation rate rho).
+            p_best: MMAS probability of building the best tour at convergence, used to derive tau_min from tau_max.
+            global_every: MMAS deposits the global best every global_every generations and the iteration best otherwise (0 always uses the iteration best).
+            stagnation: MMAS generations without improvement before the trails are reinitialized to tau_max (0 disables it).
     */
 
    	int ants;
@@ -96,6 +233,11 @@ struct ACO_params
 	int max_opt_it;
 	bool local_search;
 	bool verbose;
+	int candidates;
+	bool mmas;
+	LD p_best;
+	int global_every;
+	int stagnation;
 
 	ACO_params()
 	{
@@ -110,8 +252,14 @@ struct ACO_params
 		alpha = 1; 
 		beta = 2; 
 		decay = 0.05; 
+		max_opt_it = 1;
 		local_search = true;
 		verbose = true;
+		candidates = 0;
+		mmas = false;
+		p_best = 0.05;
+		global_every = 5;
+		stagnation = 25;
 	}
 };
 
@@ -190,6 +338,82 @@ struct annealing_params
 	}
 };
 
+struct ILS_params
+{
+	/*
+        Objective:
+            A struct responsible for storing parameters for the Iterated Local Search algorithm.
+
+        Attributes:
+            iterations - Number of kicks.
+            candidates - Candidate cities per city of the local search.
+            or_opt - Whether the local search also applies Or-opt moves (2-opt only otherwise).
+            kick_window - Maximum number of cities moved by a double-bridge kick (0 spans the whole tour).
+            acceptance - Acceptance criterion after a kick ("better", "walk", "threshold" or "anneal").
+            threshold - Accepted distance to the best tour in percent, for "threshold".
+            temperature - Initial temperature, for "anneal".
+            verbose - Defines whether to activate the verbose.
+    */
+
+	int iterations;
+	int candidates;
+	bool or_opt;
+	int kick_window;
+	string acceptance;
+	LD threshold;
+	LD temperature;
+	bool verbose;
+
+	ILS_params()
+	{
+		/*
+            Objective:
+                Default constructor initializing parameters with default values.
+        */
+
+		iterations = 1000;
+		candidates = 8;
+		or_opt = true;
+		kick_window = 50;
+		acceptance = "better";
+		threshold = 1;
+		temperature = 10;
+		verbose = false;
+	}
+};
+
+struct tabu_params
+{
+	/*
+        Objective:
+            A struct responsible for storing parameters for the Tabu Search algorithm.
+
+        Attributes:
+            iterations - Number of moves.
+            tenure - Iterations during which an edge removed by a move cannot be added back.
+            candidates - Candidate cities per city of the neighborhood.
+            verbose - Defines whether to activate the verbose.
+    */
+
+	int iterations;
+	int tenure;
+	int candidates;
+	bool verbose;
+
+	tabu_params()
+	{
+		/*
+            Objective:
+                Default constructor initializing parameters with default values.
+        */
+
+		iterations = 1000;
+		tenure = 10;
+		candidates = 8;
+		verbose = false;
+	}
+};
+
 struct GA_Params
 {
 	/*
@@ -210,7 +434,8 @@ struct GA_Params
 			fix_init = Defines whether there will be an initial number as fixed (-1 defines as not existing).
 			P_value = Defines how many parents were considered.
 			P_limiar = Defines the minimum quantity required for the city and to appear in the same position as the parents.
-			cross_active = Stores which crossovers are active ("BCR" -> Best Cost Route crossover, "AHCAVG" -> Arithmetic Average *disabled*, "ER" -> Edge Recombination crossover, "VR" -> Voting Recombination Crossover , "PMX" -> PMX Crossover).
+			seeded = Percentage of the initial population built by nearest neighbor from random start cities (the rest is random).
+			cross_active = Stores which crossovers are active ("BCR" -> Best Cost Route crossover, "AHCAVG" -> Arithmetic Average *disabled*, "ER" -> Edge Recombination crossover, "VR" -> Voting Recombination Crossover , "PMX" -> PMX Crossover, "GPX" -> Generalized Partition Crossover).
 	*/
 
 	int max_generations;
@@ -227,6 +452,7 @@ struct GA_Params
 	int P_value;
 	int repetition_limit;// *disabled*
 	int P_limiar;
+	int seeded;
 	vector<int> cross_active;
 
 	GA_Params()
@@ -246,7 +472,8 @@ struct GA_Params
 		P_limiar = 3;
 		opt_path_swap_it = 200;
 		alpha = 10;
-		cross_active = { 15, 0, 0, 0, 0};
+		seeded = 20;
+		cross_active = { 15, 0, 0, 0, 0, 0};
 	}
 
 };
@@ -259,28 +486,66 @@ class params
 
 		Attributes:
 			markdown: Indicated markdown or not.
+			threads: Number of threads of the shared thread pool (0 uses every hardware thread).
+			seed: Seed from which every random stream is derived (0 draws one from the clock).
+			distance: Distance function of instances whose file does not name one (EUC, EUC_2D, CEIL_2D, ATT or GEO).
+			hilbert: Renumbers the cities along a Hilbert curve after reading them, for cache locality.
+			time_limit: Wall-clock budget of the whole run in seconds (0 means no limit).
+			time_shares: Relative share of the budget of each stage (GA, SA, GRASP, ACO, ABC, ILS, tabu); time left by a stage is
+				redistributed among the following ones.
+			stagnation: Iterations of a stage without improvement of its best before it stops or restarts (0 disables it).
+			stagnation_action: What a stagnated stage does, "stop" or "restart" (double-bridge perturbation of its elite).
+			stagnation_restarts: Restarts allowed per stage before a stagnated stage stops.
+			min_diversity: Minimum GA population diversity in percent of edges not shared with the best gene (0 disables it).
+			elite_size: Capacity of the elite pool shared by the stages (0 disables it).
+			elite_distance: Minimum distance between elite tours in percent of edges; a closer tour competes with its neighbor.
+			elite_starts: Number of elite tours SA and GRASP start from in the pipeline (the best tour included).
+			portfolio: Runs the enabled stages at the same time on separate threads, sharing the best tour.
+			init: Construction heuristic of the initial tour ("identity", "nn", "greedy", "sfc" or "christofides").
 			hybrid: Vector indicating which hybrid algorithms are activated.
 			metrics: Vector indicating which performance metrics are activated.
 			ann_p: Annealing parameters.
 			grasp_p: GRASP parameters.
 			abc_p: ABC parameters.
 			ga_p: Genetic Algorithm parameters.
+			ils_p: Iterated Local Search parameters.
+			tabu_p: Tabu Search parameters.
 			aco_p: Ant Colony Optimization parameters.
 	*/
 
 public:
-	bool markdown;
+	bool markdown = false;
+	int threads = 0;
+	uint64_t seed = 0;
+	distance_type distance = DIST_EUC;
+	bool hilbert = false;
+	string init = "greedy";
+	bool portfolio = false;
+	int stagnation = 0;
+	string stagnation_action = "restart";
+	int stagnation_restarts = 3;
+	LD min_diversity = 0;
+	int elite_size = 10;
+	LD elite_distance = 5;
+	int elite_starts = 1;
+	LD time_limit = 0;
+	vector<LD> time_shares = {1, 1, 1, 1, 1, 1, 1};
 	vector<bool> hybrid;
 	vector<bool> metrics;
 	annealing_params ann_p;
 	grasp_params grasp_p;
 	ABC_params abc_p;
+	bound_params bound_p;
+	benchmark_params benchmark_p;
 	GA_Params ga_p;
 	ACO_params aco_p;
+	ILS_params ils_p;
+	tabu_params tabu_p;
 
 	params()
 	{
-		hybrid.assign(5, 0);
+		hybrid.assign(7, 0);
+		metrics.assign(3, 0);
 	}
 
 	params(string source)
@@ -293,7 +558,7 @@ public:
 				- source: Path to the file containing the parameters.
 		*/
 
-		hybrid.assign(5, 0);
+		hybrid.assign(7, 0);
 		metrics.assign(3, 0);
 		ifstream control_params(source);
 		string in_param;
@@ -330,6 +595,30 @@ public:
 				params::abc_params(control_params);
 			}
 
+			if (in_param == "ils")
+			{
+				hybrid[5] = true;
+				params::local_search_params(control_params);
+			}
+
+			if (in_param == "tabu")
+			{
+				hybrid[6] = true;
+				params::tabu_search_params(control_params);
+			}
+
+			if (in_param == "bound")
+			{
+				bound_p.active = true;
+				params::held_karp_params(control_params);
+			}
+
+			if (in_param == "benchmark")
+			{
+				benchmark_p.active = true;
+				params::benchmark_mode_params(control_params);
+			}
+
 			if (in_param == "MAE")
 			{
 				metrics[0] = 1;
@@ -349,7 +638,116 @@ public:
 			{
 				markdown = true;
 			}
+
+			if (in_param == "threads")
+			{
+				int value;
+				control_params >> value;
+				if (value >= 0)
+					threads = value;
+			}
+
+			if (in_param == "seed")
+			{
+				control_params >> seed;
+			}
+
+			if (in_param == "distance")
+			{
+				string name;
+				control_params >> name;
+				distance = distance_type_from(name);
+			}
+
+			if (in_param == "hilbert")
+			{
+				control_params >> hilbert;
+			}
+
+			if (in_param == "time_limit")
+			{
+				LD value;
+				control_params >> value;
+				if (value >= 0)
+					time_limit = value;
+			}
+
+			if (in_param == "time_shares")
+			{
+				for (auto& share : time_shares)
+				{
+					LD value;
+					control_params >> value;
+					share = max(value, (LD)0);
+				}
+			}
+
+			if (in_param == "stagnation")
+			{
+				int value;
+				control_params >> value;
+				if (value >= 0)
+					stagnation = value;
+			}
+
+			if (in_param == "stagnation_action")
+			{
+				control_params >> stagnation_action;
+			}
+
+			if (in_param == "stagnation_restarts")
+			{
+				int value;
+				control_params >> value;
+				if (value >= 0)
+					stagnation_restarts = value;
+			}
+
+			if (in_param == "min_diversity")
+			{
+				LD value;
+				control_params >> value;
+				if (value >= 0 && value <= 100)
+					min_diversity = value;
+			}
+
+			if (in_param == "elite_size")
+			{
+				int value;
+				control_params >> value;
+				if (value >= 0)
+					elite_size = value;
+			}
+
+			if (in_param == "elite_distance")
+			{
+				LD value;
+				control_params >> value;
+				if (value >= 0 && value <= 100)
+					elite_distance = value;
+			}
+
+			if (in_param == "elite_starts")
+			{
+				int value;
+				control_params >> value;
+				if (value > 0)
+					elite_starts = value;
+			}
+
+			if (in_param == "portfolio")
+			{
+				control_params >> portfolio;
+			}
+
+			if (in_param == "init")
+			{
+				control_params >> init;
+			}
 		}
+
+		if (!seed)
+			seed = std::chrono::system_clock::now().time_since_epoch().count();
 	}
 	
 	void genetic_params(ifstream& control_params)
@@ -383,6 +781,14 @@ public:
 				continue;
 			}
 
+			if (in_param == "genetic.seeded")
+			{
+				control_params >> value;
+				if (value >= 0 && value <= 100)
+					ga_p.seeded = value;
+				continue;
+			}
+
 			if (in_param == "genetic.max_population")
 			{
 				control_params >> value;
@@ -513,6 +919,14 @@ public:
 					ga_p.cross_active[4] = value;
 				continue;
 			}
+
+			if (in_param == "genetic.cross_active.GPX")
+			{
+				control_params >> value;
+				if(value>=0 && value<=100)
+					ga_p.cross_active[5] = value;
+				continue;
+			}
 		}
 
 		ga_p.P_value = max(0,min(ga_p.P_value, ga_p.max_population));
@@ -605,6 +1019,45 @@ public:
 					aco_p.beta = value_double;
 				continue;
 			}
+
+			if (in_param == "aco.candidates")
+			{
+				control_params >> value;
+				if (value >= 0)
+					aco_p.candidates = value;
+				continue;
+			}
+
+			if (in_param == "aco.mmas")
+			{
+				control_params >> value;
+				aco_p.mmas = value;
+				continue;
+			}
+
+			if (in_param == "aco.p_best")
+			{
+				control_params >> value_double;
+				if (value_double > 0 && value_double < 1)
+					aco_p.p_best = value_double;
+				continue;
+			}
+
+			if (in_param == "aco.global_every")
+			{
+				control_params >> value;
+				if (value >= 0)
+					aco_p.global_every = value;
+				continue;
+			}
+
+			if (in_param == "aco.stagnation")
+			{
+				control_params >> value;
+				if (value >= 0)
+					aco_p.stagnation = value;
+				continue;
+			}
 		}
 	}
 
@@ -672,14 +1125,22 @@ public:
 					abc_p.employed_percent = value_double;
 				continue;
 			}
+
+			if (in_param == "abc.selection_pressure")
+			{
+				control_params >> value_double;
+				if (value_double >= 0)
+					abc_p.selection_pressure = value_double;
+				continue;
+			}
 		}
 	}
 
-	void ann_params(ifstream& control_params)
+	void local_search_params(ifstream& control_params)
 	{
 		/*
 			Objective:
-				Parse and set the parameters for the Annealing algorithm from a file.
+				Parse and set the parameters for the Iterated Local Search algorithm from a file.
 
 			Parameters:
 				- control_params: Reference to the ifstream containing the parameter values.
@@ -691,45 +1152,71 @@ public:
 
 		while (control_params >> in_param && in_param != "end")
 		{
-			if (in_param == "annealing.t0")
+			if (in_param == "ils.iterations")
 			{
-				control_params >> value_double;
-				if (value_double > 1)
-					ann_p.t0 = value_double;
+				control_params >> value;
+				if (value > 0)
+					ils_p.iterations = value;
 				continue;
 			}
 
-			if (in_param == "annealing.tf")
+			if (in_param == "ils.candidates")
 			{
-				control_params >> value_double;
-				if (value_double > 1)
-					ann_p.tf = value_double;
+				control_params >> value;
+				if (value > 0)
+					ils_p.candidates = value;
 				continue;
 			}
-			
-			if (in_param == "annealing.l")
+
+			if (in_param == "ils.or_opt")
+			{
+				control_params >> ils_p.or_opt;
+				continue;
+			}
+
+			if (in_param == "ils.kick_window")
 			{
 				control_params >> value;
-				if (value > 1)
-					ann_p.l = value;
+				if (value >= 0)
+					ils_p.kick_window = value;
 				continue;
 			}
-			
-			if (in_param == "annealing.alpha")
+
+			if (in_param == "ils.acceptance")
+			{
+				control_params >> ils_p.acceptance;
+				continue;
+			}
+
+			if (in_param == "ils.threshold")
 			{
 				control_params >> value_double;
-				if (value_double > 1)
-					ann_p.alpha = value_double;
+				if (value_double >= 0)
+					ils_p.threshold = value_double;
+				continue;
+			}
+
+			if (in_param == "ils.temperature")
+			{
+				control_params >> value_double;
+				if (value_double >= 0)
+					ils_p.temperature = value_double;
+				continue;
+			}
+
+			if (in_param == "ils.verbose")
+			{
+				control_params >> ils_p.verbose;
 				continue;
 			}
 		}
 	}
 
-	void grasp_params(ifstream& control_params)
+	void tabu_search_params(ifstream& control_params)
 	{
 		/*
 			Objective:
-				Parse and set the parameters for the GRASP algorithm from a file.
+				Parse and set the parameters for the Tabu Search algorithm from a file.
 
 			Parameters:
 				- control_params: Reference to the ifstream containing the parameter values.
@@ -737,15 +1224,202 @@ public:
 
 		string in_param;
 		int value;
-		LD value_double;
 
 		while (control_params >> in_param && in_param != "end")
 		{
-			if (in_param == "grasp.m")
+			if (in_param == "tabu.iterations")
 			{
 				control_params >> value;
-				if (value > 1)
-					grasp_p.m = value;
+				if (value > 0)
+					tabu_p.iterations = value;
+				continue;
+			}
+
+			if (in_param == "tabu.tenure")
+			{
+				control_params >> value;
+				if (value >= 0)
+					tabu_p.tenure = value;
+				continue;
+			}
+
+			if (in_param == "tabu.candidates")
+			{
+				control_params >> value;
+				if (value > 0)
+					tabu_p.candidates = value;
+				continue;
+			}
+
+			if (in_param == "tabu.verbose")
+			{
+				control_params >> tabu_p.verbose;
+				continue;
+			}
+		}
+	}
+
+	void benchmark_mode_params(ifstream& control_params)
+	{
+		/*
+			Objective:
+				Parse and set the parameters for the benchmark mode from a file.
+
+			Parameters:
+				- control_params: Reference to the ifstream containing the parameter values.
+		*/
+
+		string in_param;
+		int value;
+		LD value_double;
+
+		while (control_params >> in_param && in_param != "end")
+		{
+			if (in_param == "benchmark.runs")
+			{
+				control_params >> value;
+				if (value > 0)
+					benchmark_p.runs = value;
+				continue;
+			}
+
+			if (in_param == "benchmark.target")
+			{
+				control_params >> value_double;
+				if (value_double >= 0)
+					benchmark_p.target = value_double;
+				continue;
+			}
+
+			if (in_param == "benchmark.output")
+			{
+				control_params >> benchmark_p.output;
+				continue;
+			}
+		}
+	}
+
+	void held_karp_params(ifstream& control_params)
+	{
+		/*
+			Objective:
+				Parse and set the parameters for the Held-Karp lower bound from a file.
+
+			Parameters:
+				- control_params: Reference to the ifstream containing the parameter values.
+		*/
+
+		string in_param;
+		int value;
+		LD value_double;
+
+		while (control_params >> in_param && in_param != "end")
+		{
+			if (in_param == "bound.iterations")
+			{
+				control_params >> value;
+				if (value > 0)
+					bound_p.iterations = value;
+				continue;
+			}
+
+			if (in_param == "bound.period")
+			{
+				control_params >> value;
+				if (value > 0)
+					bound_p.period = value;
+				continue;
+			}
+
+			if (in_param == "bound.target_gap")
+			{
+				control_params >> value_double;
+				if (value_double >= 0)
+					bound_p.target_gap = value_double;
+				continue;
+			}
+
+			if (in_param == "bound.candidates")
+			{
+				control_params >> value;
+				if (value >= 0)
+					bound_p.candidates = value;
+				continue;
+			}
+		}
+	}
+
+	void ann_params(ifstream& control_params)
+	{
+		/*
+			Objective:
+				Parse and set the parameters for the Annealing algorithm from a file.
+
+			Parameters:
+				- control_params: Reference to the ifstream containing the parameter values.
+		*/
+
+		string in_param;
+		int value;
+		LD value_double;
+
+		while (control_params >> in_param && in_param != "end")
+		{
+			if (in_param == "annealing.t0")
+			{
+				control_params >> value_double;
+				if (value_double > 1)
+					ann_p.t0 = value_double;
+				continue;
+			}
+
+			if (in_param == "annealing.tf")
+			{
+				control_params >> value_double;
+				if (value_double > 1)
+					ann_p.tf = value_double;
+				continue;
+			}
+			
+			if (in_param == "annealing.l")
+			{
+				control_params >> value;
+				if (value > 1)
+					ann_p.l = value;
+				continue;
+			}
+			
+			if (in_param == "annealing.alpha")
+			{
+				control_params >> value_double;
+				if (value_double > 1)
+					ann_p.alpha = value_double;
+				continue;
+			}
+		}
+	}
+
+	void grasp_params(ifstream& control_params)
+	{
+		/*
+			Objective:
+				Parse and set the parameters for the GRASP algorithm from a file.
+
+			Parameters:
+				- control_params: Reference to the ifstream containing the parameter values.
+		*/
+
+		string in_param;
+		int value;
+		LD value_double;
+
+		while (control_params >> in_param && in_param != "end")
+		{
+			if (in_param == "grasp.m")
+			{
+				control_params >> value;
+				if (value > 1)
+					grasp_p.m = value;
 				continue;
 			}
 
@@ -772,174 +1446,1508 @@ public:
 	}
 };
 
+class context;
 
-struct point 
+static context*& current_context()
 {
 	/*
 		Objective:
-			A structure to represent a point in the Cartesian plane with coordinates X and Y.
+			Context installed on this thread by a context_scope, or handed to a pool worker by the caller of the loop
+			it runs (null when there is none).
 	*/
 
-	LD X, Y;
-	point(LD x, LD y) : X(x), Y(y) {}
-};
+	thread_local context* current = nullptr;
+	return current;
+}
 
-class utilities
+class thread_pool
 {
-    /*
-        Objective:
-            Utility class containing various useful functions for solving optimization problems.
+	/*
+		Objective:
+			Fixed set of worker threads that run the iterations of a loop in parallel.
+			The calling thread takes part in the work, and nested or concurrent calls run inline,
+			so a solver may always call parallel_for without knowing who else is using the pool.
 
 		Attributes:
-			param: Object of class params containing algorithm parameters.
-			n_cities: Number of cities.
-			city: Vector containing points representing cities in the Cartesian plane
-			input_predicted: Input predicted.
+			workers: Worker threads (the pool has workers.size() + 1 threads counting the caller).
+			requested: Number of threads the pool was created with (0 for every hardware thread).
+			task: Body of the loop being executed.
+			origin: Context of the caller of the loop, installed on the workers while they run it.
+			next: Next loop index to be claimed.
+			total: Number of iterations of the loop being executed.
+			running: Number of workers still busy with the current loop.
+			round: Counter used to wake the workers for a new loop.
+			stop: Tells the workers to finish.
 	*/
 
+	vector<thread> workers;
+	int requested = 0;
+	mutex lock, calling;
+	condition_variable wake, done;
+	const function<void(int)>* task = nullptr;
+	context* origin = nullptr;
+	atomic<int> next;
+	int total = 0;
+	int running = 0;
+	long long round = 0;
+	bool stop = false;
+
+	static bool& inside_pool()
+	{
+		thread_local bool inside = false;
+		return inside;
+	}
+
+	void run_tasks()
+	{
+		for (int i = next.fetch_add(1); i < total; i = next.fetch_add(1))
+			(*task)(i);
+	}
+
+	void worker_loop()
+	{
+		inside_pool() = true;
+		long long seen = 0;
+
+		while (true)
+		{
+			{
+				unique_lock<mutex> guard(lock);
+				wake.wait(guard, [&] { return stop || round != seen; });
+
+				if (stop)
+					return;
+
+				seen = round;
+				current_context() = origin;
+			}
+
+			run_tasks();
+			current_context() = nullptr;
+
+			lock_guard<mutex> guard(lock);
+			if (--running == 0)
+				done.notify_one();
+		}
+	}
+
 public:
-	static params param;
-	static LD input_predicted;
-	static int n_cities;
-	static vector<point> city;
-	
-	static void random_path(const int& initial,const bool& reapeat, LD& fit, vector<int>& path, vector<bool>& contain)
+	thread_pool(int n_threads)
 	{
 		/*
 			Objective:
-				Method that creates a random path.
+				Start the worker threads.
+
 			Parameters:
-				- initial: Initial index for the path.
-				- repeat: Flag indicating whether to allow repeated cities in the path.
-				- fit: Reference to the fitness value of the generated path.
-				- path: Reference to the generated path.
-				- contain: Vector indicating which cities are included in the path.
+				- n_threads: Total number of threads, counting the caller (0 uses every hardware thread).
+		*/
+
+		requested = n_threads;
+		n_threads = resolve(n_threads);
+
+		next = 0;
+		for (int i = 1; i < n_threads; i++)
+			workers.emplace_back(&thread_pool::worker_loop, this);
+	}
+
+	~thread_pool()
+	{
+		{
+			lock_guard<mutex> guard(lock);
+			stop = true;
+		}
+
+		wake.notify_all();
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	static int resolve(int n_threads)
+	{
+		/*
+			Objective:
+				Number of threads a pool created with n_threads has (0 or less uses every hardware thread).
+		*/
+
+		return (n_threads <= 0 ? max(1u, thread::hardware_concurrency()) : n_threads);
+	}
+
+	int size() const
+	{
+		return workers.size() + 1;
+	}
+
+	bool fits(int n_threads) const
+	{
+		/*
+			Objective:
+				Whether the pool has the number of threads a "threads" parameter of n_threads asks for.
+		*/
+
+		return n_threads == requested || resolve(n_threads) == size();
+	}
+
+	void parallel_for(int n, const function<void(int)>& body)
+	{
+		/*
+			Objective:
+				Run body(i) for every i in [0, n), spreading the indices across the pool.
+				Returns only after every iteration has finished.
+
+			Parameters:
+				- n: Number of iterations.
+				- body: Loop body, it must only write to data owned by its own index.
+		*/
+
+		if (workers.empty() || n < 2 || inside_pool())
+		{
+			for (int i = 0; i < n; i++)
+				body(i);
+			return;
+		}
+
+		unique_lock<mutex> call(calling, try_to_lock);
+		if (!call.owns_lock())
+		{
+			for (int i = 0; i < n; i++)
+				body(i);
+			return;
+		}
+
+		{
+			lock_guard<mutex> guard(lock);
+			task = &body;
+			origin = current_context();
+			total = n;
+			next = 0;
+			running = workers.size();
+			round++;
+		}
+
+		wake.notify_all();
+		inside_pool() = true;
+		run_tasks();
+		inside_pool() = false;
+
+		unique_lock<mutex> guard(lock);
+		done.wait(guard, [&] { return running == 0; });
+		task = nullptr;
+	}
+};
+
+enum rng_component
+{
+	/*
+		Objective:
+			Identifies the owner of a random stream, so every component draws from its own sequence.
+	*/
+
+	RNG_THREAD,
+	RNG_MAIN,
+	RNG_GA,
+	RNG_SA,
+	RNG_GRASP,
+	RNG_ACO,
+	RNG_ABC,
+	RNG_ILS,
+	RNG_TABU
+};
+
+class philox
+{
+	/*
+		Objective:
+			Philox4x32-10 counter-based generator. A stream is fully defined by its key (seed, stage) and its
+			counter (generation, individual, block), so the numbers a task receives depend only on who the task is,
+			never on which thread runs it or on what other tasks drew before.
+			It satisfies UniformRandomBitGenerator, so it also works with std::shuffle and <random>.
+
+		Attributes:
+			key: 64-bit key derived from the seed and the stage.
+			counter: {block low, block high, individual, generation}.
+			block: Last 128 bits produced.
+			used: How many words of block were already returned.
+	*/
+
+	uint32_t key[2];
+	uint32_t counter[4];
+	uint32_t block[4];
+	int used;
+
+	static void mulhilo(uint32_t a, uint32_t b, uint32_t& hi, uint32_t& lo)
+	{
+		uint64_t product = (uint64_t)a * b;
+		hi = product >> 32;
+		lo = (uint32_t)product;
+	}
+
+	void next_block()
+	{
+		uint32_t c[4] = {counter[0], counter[1], counter[2], counter[3]};
+		uint32_t k[2] = {key[0], key[1]};
+
+		for (int round = 0; round < 10; round++)
+		{
+			uint32_t hi0, lo0, hi1, lo1;
+			mulhilo(0xD2511F53, c[0], hi0, lo0);
+			mulhilo(0xCD9E8D57, c[2], hi1, lo1);
+
+			c[0] = hi1 ^ c[1] ^ k[0];
+			c[1] = lo1;
+			c[2] = hi0 ^ c[3] ^ k[1];
+			c[3] = lo0;
+
+			k[0] += 0x9E3779B9;
+			k[1] += 0xBB67AE85;
+		}
+
+		for (int i = 0; i < 4; i++)
+			block[i] = c[i];
+
+		if (++counter[0] == 0)
+			counter[1]++;
+
+		used = 0;
+	}
+
+public:
+	typedef uint32_t result_type;
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return UINT32_MAX; }
+
+	static uint64_t splitmix64(uint64_t x)
+	{
+		/*
+			Objective:
+				SplitMix64 finalizer, used to mix the seed and the stage into the key.
+		*/
+
+		uint64_t z = x + 0x9e3779b97f4a7c15ULL;
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	}
+
+	philox(uint64_t seed = 0, uint32_t stage = 0, uint32_t generation = 0, uint32_t individual = 0)
+	{
+		reset(seed, stage, generation, individual);
+	}
+
+	void reset(uint64_t seed, uint32_t stage, uint32_t generation, uint32_t individual)
+	{
+		/*
+			Objective:
+				Position the generator at the start of the stream of (seed, stage, generation, individual).
+		*/
+
+		uint64_t mixed = splitmix64(seed ^ splitmix64(stage));
+		key[0] = (uint32_t)mixed;
+		key[1] = mixed >> 32;
+		counter[0] = counter[1] = 0;
+		counter[2] = individual;
+		counter[3] = generation;
+		used = 4;
+	}
+
+	result_type operator()()
+	{
+		if (used == 4)
+			next_block();
+
+		return block[used++];
+	}
+
+	int bounded(int n)
+	{
+		/*
+			Objective:
+				Random integer in [0, n) with Lemire's multiply-shift (no division on the fast path, no modulo bias).
+		*/
+
+		uint32_t range = n;
+		uint64_t m = (uint64_t)(*this)() * range;
+		uint32_t low = (uint32_t)m;
+
+		if (low < range)
+		{
+			uint32_t threshold = -range % range;
+			while (low < threshold)
+			{
+				m = (uint64_t)(*this)() * range;
+				low = (uint32_t)m;
+			}
+		}
+
+		return m >> 32;
+	}
+
+	double real()
+	{
+		/*
+			Objective:
+				Random real number in [0, 1) built from 53 random bits.
+		*/
+
+		uint64_t bits = ((uint64_t)(*this)() << 21) ^ ((*this)() >> 11);
+		return bits * 0x1.0p-53;
+	}
+};
+
+struct alias_table
+{
+	/*
+		Objective:
+			Walker/Vose alias table to draw indices proportionally to their weights in O(1) per draw.
+
+		Attributes:
+			prob: Probability of keeping the drawn column instead of its alias.
+			alias: Alternative index of each column.
+			small, large: Scratch lists reused by build.
+	*/
+
+	vector<LD> prob;
+	vector<int> alias;
+	vector<int> small, large;
+
+	void build(const vector<LD>& weights)
+	{
+		/*
+			Objective:
+				Build the table in O(n) from non-negative weights (all zero weights give a uniform draw).
+		*/
+
+		int n = weights.size();
+		LD sum = 0;
+
+		for (auto w : weights)
+			sum += w;
+
+		prob.assign(n, 1);
+		alias.assign(n, 0);
+		small.clear();
+		large.clear();
+
+		if (sum <= 0)
+			return;
+
+		for (int i = 0; i < n; i++)
+		{
+			prob[i] = weights[i] * n / sum;
+			alias[i] = i;
+			(prob[i] < 1 ? small : large).push_back(i);
+		}
+
+		while (!small.empty() && !large.empty())
+		{
+			int s = small.back(), l = large.back();
+			small.pop_back();
+
+			alias[s] = l;
+			prob[l] += prob[s] - 1;
+
+			if (prob[l] < 1)
+			{
+				large.pop_back();
+				small.push_back(l);
+			}
+		}
+
+		for (auto i : small)
+			prob[i] = 1;
+		for (auto i : large)
+			prob[i] = 1;
+	}
+
+	int sample(philox& rng) const
+	{
+		/*
+			Objective:
+				Draw one index.
+		*/
+
+		int i = rng.bounded(prob.size());
+		return (rng.real() < prob[i] ? i : alias[i]);
+	}
+};
+
+class cancel_token
+{
+	/*
+		Objective:
+			Cooperative cancellation shared by every solver: the main loops poll stop_requested() and return their best
+			tour so far once it is set, either explicitly through cancel() or by reaching the deadline.
+			The deadline is only changed between stages, while no solver is polling it.
+
+		Attributes:
+			cancelled: Explicit cancellation flag.
+			deadline: Instant after which stop is requested (time_point::max() when there is none).
+	*/
+
+	atomic<bool> cancelled{false};
+	chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+
+public:
+	void cancel()
+	{
+		cancelled.store(true, memory_order_relaxed);
+	}
+
+	void expire_at(const chrono::steady_clock::time_point& instant)
+	{
+		deadline = instant;
+	}
+
+	void clear_deadline()
+	{
+		deadline = chrono::steady_clock::time_point::max();
+	}
+
+	bool stop_requested() const
+	{
+		if (cancelled.load(memory_order_relaxed))
+			return true;
+
+		return deadline != chrono::steady_clock::time_point::max() && chrono::steady_clock::now() >= deadline;
+	}
+};
+
+class target_watch
+{
+	/*
+		Objective:
+			Records when the best tour of a run first reached a target cost. Solvers report their best cost at every
+			stop check, possibly from several threads at once.
+
+		Attributes:
+			target: Cost to reach (0 disables the watch).
+			start: Start of the run.
+			reached: Seconds from the start to the first report at or below the target (-1 while it is not reached).
+	*/
+
+	LD target = 0;
+	chrono::steady_clock::time_point start;
+	atomic<double> reached{-1};
+
+public:
+	void arm(const LD& cost)
+	{
+		target = cost;
+		start = chrono::steady_clock::now();
+		reached.store(-1);
+	}
+
+	void observe(const COST& cost)
+	{
+		if (target <= 0 || (LD)cost > target + 1e-9 || reached.load(memory_order_relaxed) >= 0)
+			return;
+
+		double expected = -1;
+		reached.compare_exchange_strong(expected, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+	}
+
+	double seconds() const
+	{
+		return reached.load();
+	}
+};
+
+class incumbent
+{
+	/*
+		Objective:
+			Best tour shared by solvers running concurrently. Each improvement publishes a new immutable snapshot with a
+			compare-and-swap on the current pointer, so readers and writers never block. A replaced snapshot is retired
+			and freed once no push or pull is in flight: every access counts itself in readers before loading the
+			current pointer, so a snapshot unlinked before the retired list is taken can only be held by an access that
+			is still counted. Memory stays bounded by the snapshots retired while some access was running.
+
+		Attributes:
+			current: Latest (cheapest) snapshot.
+			retired: Stack of replaced snapshots waiting to be freed, linked through next.
+			readers: Number of push and pull calls in flight.
+	*/
+
+	struct snapshot
+	{
+		COST cost;
+		vector<int> path;
+		snapshot* next;
+	};
+
+	atomic<snapshot*> current, retired;
+	atomic<int> readers;
+
+	static void release(snapshot* s)
+	{
+		while (s)
+		{
+			snapshot* next = s->next;
+			delete s;
+			s = next;
+		}
+	}
+
+	void retire(snapshot* first, snapshot* last)
+	{
+		last->next = retired.load();
+		while (!retired.compare_exchange_weak(last->next, first));
+	}
+
+	void leave()
+	{
+		/*
+			Objective:
+				End an access and free the retired snapshots when no other access is in flight.
+		*/
+
+		readers.fetch_sub(1);
+
+		snapshot* list = retired.exchange(nullptr);
+		if (!list)
+			return;
+
+		if (readers.load() == 0)
+		{
+			release(list);
+			return;
+		}
+
+		snapshot* last = list;
+		while (last->next)
+			last = last->next;
+		retire(list, last);
+	}
+
+public:
+	incumbent(const vector<int>& path, const COST& cost) : retired(nullptr), readers(0)
+	{
+		current.store(new snapshot{cost, path, nullptr});
+	}
+
+	~incumbent()
+	{
+		release(current.load());
+		release(retired.load());
+	}
+
+	incumbent(const incumbent&) = delete;
+	incumbent& operator=(const incumbent&) = delete;
+
+	COST cost()
+	{
+		readers.fetch_add(1);
+		COST value = current.load()->cost;
+		leave();
+		return value;
+	}
+
+	bool push(const vector<int>& path, const COST& cost)
+	{
+		/*
+			Objective:
+				Publish a tour if it is cheaper than the incumbent.
+			Returns:
+				Whether the tour became the incumbent.
+		*/
+
+		readers.fetch_add(1);
+
+		snapshot* seen = current.load();
+		if (cost >= seen->cost)
+		{
+			leave();
+			return false;
+		}
+
+		snapshot* fresh = new snapshot{cost, path, nullptr};
+		while (!current.compare_exchange_weak(seen, fresh))
+		{
+			if (cost >= seen->cost)
+			{
+				delete fresh;
+				leave();
+				return false;
+			}
+		}
+
+		retire(seen, seen);
+		leave();
+		return true;
+	}
+
+	bool pull(vector<int>& path, COST& cost)
+	{
+		/*
+			Objective:
+				Replace a tour by the incumbent if the incumbent is cheaper.
+			Returns:
+				Whether the tour was replaced.
+		*/
+
+		readers.fetch_add(1);
+
+		snapshot* seen = current.load();
+		bool better = seen->cost < cost;
+		if (better)
+		{
+			path = seen->path;
+			cost = seen->cost;
+		}
+
+		leave();
+		return better;
+	}
+};
+
+class elite_pool
+{
+	/*
+		Objective:
+			Bounded pool of good and diverse tours that every stage can read from and write to, so the tours a stage
+			found are handed to the next ones instead of only its best. Admission uses the edge distance (number of
+			edges of one tour missing from the other): a tour closer than the minimum distance to a member only
+			replaces that member when it is cheaper; otherwise it fills a free slot or replaces the most expensive
+			member. Access is serialized by a mutex, since portfolio stages offer tours concurrently.
+
+		Attributes:
+			members: Tours sorted by cost, with the successor and predecessor of every city for the distance.
+			capacity: Maximum number of tours (0 disables the pool).
+			min_distance: Minimum edge distance between two members.
+	*/
+
+	struct member
+	{
+		COST cost;
+		vector<int> path, next, prev;
+	};
+
+	vector<member> members;
+	int capacity = 0;
+	int min_distance = 0;
+	mutable mutex lock;
+
+	static int distance(const vector<int>& path, const member& other)
+	{
+		int n = path.size(), missing = 0;
+
+		for (int i = 0; i < n; i++)
+		{
+			int a = path[i], b = path[i + 1 == n ? 0 : i + 1];
+			missing += (other.next[a] != b && other.prev[a] != b);
+		}
+
+		return missing;
+	}
+
+public:
+	void reset(const int& size, const int& distance)
+	{
+		/*
+			Objective:
+				Empty the pool and set its capacity and minimum edge distance.
+		*/
+
+		lock_guard<mutex> guard(lock);
+		members.clear();
+		capacity = size;
+		min_distance = distance;
+	}
+
+	bool offer(const vector<int>& path, const COST& cost)
+	{
+		/*
+			Objective:
+				Offer a tour to the pool.
+			Returns:
+				Whether the tour was admitted.
+		*/
+
+		lock_guard<mutex> guard(lock);
+		int n = path.size(), closest = -1, closest_distance = INT_MAX;
+
+		if (capacity <= 0 || n == 0)
+			return false;
+
+		for (int i = 0; i < (int)members.size(); i++)
+		{
+			int d = distance(path, members[i]);
+			if (d < closest_distance)
+				closest = i, closest_distance = d;
+		}
+
+		if (closest != -1 && (closest_distance < min_distance || closest_distance == 0))
+		{
+			if (cost >= members[closest].cost)
+				return false;
+			members.erase(members.begin() + closest);
+		}
+		else if ((int)members.size() >= capacity)
+		{
+			if (cost >= members.back().cost)
+				return false;
+			members.pop_back();
+		}
+
+		member fresh{cost, path, vector<int>(n), vector<int>(n)};
+		for (int i = 0; i < n; i++)
+		{
+			fresh.next[path[i]] = path[i + 1 == n ? 0 : i + 1];
+			fresh.prev[path[i + 1 == n ? 0 : i + 1]] = path[i];
+		}
+
+		auto at = upper_bound(members.begin(), members.end(), cost, [](const COST& c, const member& m) { return c < m.cost; });
+		members.insert(at, move(fresh));
+		return true;
+	}
+
+	vector<pair<COST, vector<int>>> tours() const
+	{
+		/*
+			Objective:
+				Copy of the tours in the pool with their costs, cheapest first.
+		*/
+
+		lock_guard<mutex> guard(lock);
+		vector<pair<COST, vector<int>>> copy;
+
+		for (auto& m : members)
+			copy.push_back({m.cost, m.path});
+
+		return copy;
+	}
+};
+
+struct point 
+{
+	/*
+		Objective:
+			A structure to represent a point in the Cartesian plane with coordinates X and Y.
+	*/
+
+	LD X, Y;
+	point(LD x, LD y) : X(x), Y(y) {}
+};
+
+class context
+{
+	/*
+		Objective:
+			State of one solve: the instance, the parameters and the run state shared by its stages. Solvers receive
+			the context they work on and install it on their thread with a context_scope (the thread pool hands it on
+			to its workers), so the utilities reach the instance without process-wide state and independent contexts
+			can be solved at the same time on different threads.
+
+		Attributes:
+			param: Object of class params containing algorithm parameters.
+			n_cities: Number of cities.
+			city: Vector containing points representing cities in the Cartesian plane
+			input_predicted: Input predicted.
+			weight_type: Distance function of the instance.
+			int_dist: Flat n x n store of the integer distances (empty for real distances or very large instances).
+			xs, ys: Structure-of-arrays copy of the coordinates used by the SIMD kernels.
+			original_id: Input file index of each city after a renumbering (empty when the input order is kept).
+			lower_bound: Held-Karp lower bound of the instance (0 when it was not computed).
+			alpha_near: Flat list of the alpha-nearest cities of every city (empty when it was not computed).
+			shared: Incumbent shared by the solvers in portfolio mode (null when the stages run one after another).
+			elites: Elite pool shared by the stages.
+			stop_token: Cancellation token polled by the main loop of every solver.
+			target_clock: Time to target of the current run, fed by the stop checks.
+			fallback_rng: Stream of the random draws made outside any rng_scope, keyed only on the seed.
+	*/
+
+public:
+	params param;
+	LD input_predicted = 0;
+	int n_cities = 0;
+	vector<point> city;
+	distance_type weight_type = DIST_EUC;
+	vector<int32_t> int_dist;
+	vector<double> xs, ys;
+	vector<int> original_id;
+	LD lower_bound = 0;
+	vector<int> alpha_near;
+	incumbent* shared = nullptr;
+	elite_pool elites;
+	cancel_token stop_token;
+	target_watch target_clock;
+	philox fallback_rng;
+
+	context() : fallback_rng(param.seed, RNG_THREAD) {}
+
+	context(const string& source) : param(source), fallback_rng(param.seed, RNG_THREAD) {}
+
+	context(const context& base, const uint64_t& seed) : param(base.param), input_predicted(base.input_predicted), n_cities(base.n_cities),
+		city(base.city), weight_type(base.weight_type), int_dist(base.int_dist), xs(base.xs), ys(base.ys), original_id(base.original_id)
+	{
+		/*
+			Objective:
+				Copy of the instance and the parameters of another context, with another seed and a fresh run state.
+		*/
+
+		param.seed = seed;
+		fallback_rng = philox(seed, RNG_THREAD);
+	}
+
+	context(const context&) = delete;
+	context& operator=(const context&) = delete;
+};
+
+class context_scope
+{
+	/*
+		Objective:
+			Installs a context as the current context of the thread for the lifetime of the object.
+	*/
+
+	context* previous;
+
+public:
+	context_scope(context& instance)
+	{
+		previous = current_context();
+		current_context() = &instance;
+	}
+
+	~context_scope()
+	{
+		current_context() = previous;
+	}
+};
+
+class utilities
+{
+    /*
+        Objective:
+            Utility class containing various useful functions for solving optimization problems.
+            They work on the context installed on the calling thread.
+	*/
+
+public:
+	static context& ctx()
+	{
+		/*
+			Objective:
+				Context of the solve running on this thread.
+		*/
+
+		return *current_context();
+	}
+
+	static bool should_stop(const COST& cost)
+	{
+		/*
+			Objective:
+				Whether a solver whose best tour costs cost should stop: the time budget ran out, the run was
+				cancelled, or the target gap was reached.
+		*/
+
+		ctx().target_clock.observe(cost);
+		return ctx().stop_token.stop_requested() || gap_reached(cost);
+	}
+
+	static bool share(vector<int>& path, COST& cost)
+	{
+		/*
+			Objective:
+				Checkpoint of a solver in portfolio mode: publish its best tour and take the incumbent if it is better.
+			Parameters:
+				- path: Best tour of the solver, replaced by the incumbent when that one is cheaper.
+				- cost: Cost of the tour.
+			Returns:
+				Whether the tour was replaced (always false outside portfolio mode).
+		*/
+
+		if (!ctx().shared)
+			return false;
+
+		ctx().shared->push(path, cost);
+		return ctx().shared->pull(path, cost);
+	}
+
+	static LD gap(const COST& cost)
+	{
+		/*
+			Objective:
+				Gap of a tour cost to the lower bound, in percent (-1 when no bound is known).
+		*/
+
+		if (ctx().lower_bound <= 0)
+			return -1;
+
+		return ((LD)cost - ctx().lower_bound) / ctx().lower_bound * 100;
+	}
+
+	static bool gap_reached(const COST& cost)
+	{
+		/*
+			Objective:
+				Whether a tour cost is within the target gap of the lower bound, so the search can stop.
+		*/
+
+		return ctx().param.bound_p.target_gap > 0 && ctx().lower_bound > 0 && gap(cost) <= ctx().param.bound_p.target_gap;
+	}
+
+	static vector<int> candidate_lists(int k)
+	{
+		/*
+			Objective:
+				Candidate lists of k cities per city: the alpha-nearest ones when the lower bound computed enough of them,
+				the nearest ones otherwise.
+			Returns:
+				Flat vector where the candidates of city i, best first, are at [i * k, (i + 1) * k).
+		*/
+
+		k = max(0, min(k, ctx().n_cities - 1));
+		int stored = (ctx().n_cities ? (int)ctx().alpha_near.size() / ctx().n_cities : 0);
+
+		if (!k || stored < k)
+			return nearest_neighbors(k);
+
+		vector<int> candidates(ctx().n_cities * k);
+		for (int i = 0; i < ctx().n_cities; i++)
+			for (int j = 0; j < k; j++)
+				candidates[i * k + j] = ctx().alpha_near[i * stored + j];
+
+		return candidates;
+	}
+	
+	static vector<int> remaining_cities(const int& initial, const bool& reapeat)
+	{
+		/*
+			Objective:
+				Shuffled list of every city except the initial one, so a random path is filled in O(n) instead of
+				retrying random cities until an unused one comes up.
+			Parameters:
+				- initial: City already placed at the start of the path.
+				- repeat: Flag indicating whether repeated cities are allowed (no list is needed then).
+		*/
+
+		vector<int> order;
+		if (reapeat)
+			return order;
+
+		order.reserve(ctx().n_cities - 1);
+		for (int i = 0; i < ctx().n_cities; i++)
+			if (i != initial)
+				order.push_back(i);
+
+		shuffle(order.begin(), order.end(), rng());
+		return order;
+	}
+
+	static void random_path(const int& initial,const bool& reapeat, COST& fit, vector<int>& path, vector<bool>& contain)
+	{
+		/*
+			Objective:
+				Method that creates a random path.
+			Parameters:
+				- initial: Initial index for the path.
+				- repeat: Flag indicating whether to allow repeated cities in the path.
+				- fit: Reference to the fitness value of the generated path.
+				- path: Reference to the generated path.
+				- contain: Vector indicating which cities are included in the path.
+		*/
+
+		path[0] = initial;
+		contain[initial] = 1;
+		
+		vector<int> order = remaining_cities(initial, reapeat);
+
+		for (int i = 1; i < ctx().n_cities; i++)
+		{
+			int idx = reapeat ? utilities::random_range(0, ctx().n_cities) : order[i - 1];
+			path[i] = idx;
+			contain[idx] = 1;
+		}
+		fit = Fx_fit(path, ctx().n_cities, contain);
+	}
+
+	static void random_path(const int& initial,const bool& reapeat, COST& fit, vector<int>& path, vector<int>& repath, vector<bool>& contain)
+	{
+		/*
+			Objective:
+				Method that creates a random path.
+			Parameters:
+				- initial: Initial index for the path.
+				- repeat: Flag indicating whether to allow repeated cities in the path.
+				- fit: Reference to the fitness value of the generated path.
+				- path: Reference to the generated path.
+				- repath: Reference to the path represented by city indices.
+				- contain: Vector indicating which cities are included in the path.
+		*/
+
+		path[0] = initial;
+		repath[initial] = 0;
+		contain[initial] = 1;
+		
+		vector<int> order = remaining_cities(initial, reapeat);
+
+		for (int i = 1; i < ctx().n_cities; i++)
+		{
+			int idx = reapeat ? utilities::random_range(0, ctx().n_cities) : order[i - 1];
+			path[i] = idx;
+			repath[idx] = i;
+			contain[idx] = 1;
+		}
+		fit = Fx_fit(path, ctx().n_cities, contain);
+	}
+
+	static LD euclidian_distance(const point& a, const point& b)
+	{
+		/*
+			Objective:
+				Calculate the Euclidean distance between two points.
+			Parameters:
+				- a: First point.
+				- b: Second point.
+			Returns:
+				Euclidean distance between points a and b.
+		*/
+
+		return sqrt((a.X - b.X) * (a.X - b.X) + (a.Y - b.Y) * (a.Y - b.Y));
+	}
+
+	static bool simd_distances()
+	{
+		/*
+			Objective:
+				Whether the SIMD kernels compute the same distances as utilities::distance
+				(real Euclidean distances and a floating point cost type).
+		*/
+
+		return ctx().weight_type == DIST_EUC && !is_integral<COST>::value;
+	}
+
+	static COST tour_length(const vector<int>& path, const int& n)
+	{
+		/*
+			Objective:
+				Length of the closed tour formed by the first n cities of the path.
+		*/
+
+		if (simd_distances())
+			return (COST)simd_kernels::get().tour_length(ctx().xs.data(), ctx().ys.data(), path.data(), n);
+
+		COST fit = 0;
+
+		for (int i = 0; i < n - 1; i++)
+		{
+			fit += utilities::distance(path[i], path[i + 1]);
+		}
+
+		return fit + utilities::distance(path[n-1], path[0]);
+	}
+
+	static void simd_pair_deltas(const int& a, const int& b, const int* c, const int* d, const int& k, const double& base, double* out)
+	{
+		simd_kernels::get().pair_deltas(ctx().xs.data(), ctx().ys.data(), a, b, c, d, k, base, out);
+	}
+
+	template <typename T>
+	static void simd_pair_deltas(const int& a, const int& b, const int* c, const int* d, const int& k, const T& base, T* out)
+	{
+		// The kernels work in double: other real cost types go through a conversion buffer.
+		thread_local vector<double> lanes;
+		lanes.resize(k);
+		simd_kernels::get().pair_deltas(ctx().xs.data(), ctx().ys.data(), a, b, c, d, k, (double)base, lanes.data());
+		for (int t = 0; t < k; t++)
+			out[t] = (T)lanes[t];
+	}
+
+	static void pair_deltas(const int& a, const int& b, const int* c, const int* d, const int& k, const COST& base, COST* out)
+	{
+		/*
+			Objective:
+				Batched move evaluation: out[t] = base + dist(a, c[t]) + dist(b, d[t]) - dist(c[t], d[t]) for t < k.
+				With base = -dist(a, b) these are 2-opt deltas, with a = b the insertion part of Or-opt deltas.
+				Integer distance modes sum exact distances in the cost type.
+		*/
+
+		if (simd_distances())
+		{
+			simd_pair_deltas(a, b, c, d, k, base, out);
+			return;
+		}
+
+		for (int t = 0; t < k; t++)
+			out[t] = base + distance(a, c[t]) + distance(b, d[t]) - distance(c[t], d[t]);
+	}
+
+	static COST Fx_fit(const vector<int>& path, const int& n, const vector<bool>& contain)
+	{
+		/*
+			Objective:
+				Calculate the fitness value of a path based on the total distance traveled and city inclusion.
+			Parameters:
+				- path: Path represented by a vector of city indices.
+				- n: Number of cities.
+				- contain: Vector indicating which cities are included in the path.
+			Returns:
+				Fitness value of the path.
+		*/
+
+		COST fit = tour_length(path, n);
+
+		for (int i = 0; i < n; i++)
+		{
+			if (!contain[i])
+			{
+
+				fit = INF - fit;
+				return fit;
+			}
+		}
+
+		return fit;
+	}
+
+	static COST Fx_fit(const vector<int>& path, const int& n)
+	{
+		/*
+			Objective:
+				Calculate the fitness value of a path based on the total distance traveled.
+			Parameters:
+				- path: Path represented by a vector of city indices.
+				- n: Number of cities.
+			Returns:
+				Fitness value of the path.
+		*/
+
+		COST fit = tour_length(path, n);
+
+		return fit;
+	}
+
+	static philox stream(rng_component component, uint32_t generation = 0, uint32_t individual = 0)
+	{
+		/*
+			Objective:
+				Build the counter-based stream of one task, derived only from the "seed" parameter and the task identity.
+			Parameters:
+				- component: Stage that owns the task.
+				- generation: Generation, cycle or iteration of the task.
+				- individual: Index of the task inside its generation (child, ant, bee...).
+		*/
+
+		return philox(ctx().param.seed, component, generation, individual);
+	}
+
+	static philox*& current_rng()
+	{
+		/*
+			Objective:
+				Stream installed on this thread by an rng_scope (null when there is none).
+		*/
+
+		thread_local philox* current = nullptr;
+		return current;
+	}
+
+	static philox& rng()
+	{
+		/*
+			Objective:
+				Random stream of the calling thread: the one installed by the running task, or else the fallback stream
+				of the current context. Every parallel task installs its own rng_scope, so the fallback is only drawn
+				from by the thread that owns the context, and its draws depend only on the seed.
+		*/
+
+		philox* current = current_rng();
+		return (current ? *current : ctx().fallback_rng);
+	}
+
+	static thread_pool& start_pool(int threads)
+	{
+		/*
+			Objective:
+				Create the process-wide thread pool with the given "threads" parameter. Only the first call creates it;
+				main calls it before the first solve.
+		*/
+
+		static thread_pool shared(threads);
+		return shared;
+	}
+
+	static thread_pool& pool()
+	{
+		/*
+			Objective:
+				Process-wide thread pool used by the parallel parts of the solvers (created from the current context
+				when start_pool was not called). Its size is fixed for the process: a context asking for another
+				number of threads is reported once on stderr and runs on the existing pool.
+		*/
+
+		thread_pool& shared = start_pool(ctx().param.threads);
+
+		static atomic<bool> reported(false);
+		if (!shared.fits(ctx().param.threads) && !reported.exchange(true))
+			cerr << "threads " << ctx().param.threads << " ignored: the thread pool already runs " << shared.size() << " threads" << endl;
+
+		return shared;
+	}
+
+	static vector<int> nearest_neighbors(int k)
+	{
+		/*
+			Objective:
+				Build the list of the k nearest cities of every city.
+			Parameters:
+				- k: Number of neighbors per city (clamped to n_cities - 1).
+			Returns:
+				Flat vector where the neighbors of city i, closest first, are at [i * k, (i + 1) * k).
+		*/
+
+		k = max(0, min(k, ctx().n_cities - 1));
+		vector<int> neighbors(ctx().n_cities * k);
+		vector<pair<LD, int>> order;
+
+		for (int i = 0; i < ctx().n_cities; i++)
+		{
+			order.clear();
+			for (int j = 0; j < ctx().n_cities; j++)
+				if (j != i)
+					order.push_back({(LD)distance(i, j), j});
+
+			partial_sort(order.begin(), order.begin() + k, order.end());
+
+			for (int j = 0; j < k; j++)
+				neighbors[i * k + j] = order[j].second;
+		}
+
+		return neighbors;
+	}
+
+	static COST to_cost(const LD& value)
+	{
+		/*
+			Objective:
+				Convert a real distance to the cost type, rounding to the nearest integer for integer cost types.
+		*/
+
+		if (is_integral<COST>::value)
+			return (COST)llround(value);
+
+		return (COST)value;
+	}
+
+	static LD geo_radians(const LD& value)
+	{
+		/*
+			Objective:
+				Convert a TSPLIB GEO coordinate (DDD.MM degrees and minutes) to radians.
+		*/
+
+		const LD pi = 3.141592;
+		int deg = (int)value;
+		LD min = value - deg;
+		return pi * (deg + 5.0 * min / 3.0) / 180.0;
+	}
+
+	static int32_t tsplib_distance(const point& a, const point& b)
+	{
+		/*
+			Objective:
+				TSPLIB integer distance between two points for the integer weight types.
+			Parameters:
+				- a: First point.
+				- b: Second point.
+			Returns:
+				Distance as defined by the TSPLIB documentation for weight_type.
+		*/
+
+		LD dx = a.X - b.X, dy = a.Y - b.Y;
+
+		if (ctx().weight_type == DIST_CEIL_2D)
+			return (int32_t)ceil(sqrt(dx * dx + dy * dy));
+
+		if (ctx().weight_type == DIST_ATT)
+		{
+			LD r = sqrt((dx * dx + dy * dy) / 10.0);
+			int32_t t = (int32_t)(r + 0.5);
+			return (t < r ? t + 1 : t);
+		}
+
+		if (ctx().weight_type == DIST_GEO)
+		{
+			const LD rrr = 6378.388;
+			LD lat_a = geo_radians(a.X), lon_a = geo_radians(a.Y);
+			LD lat_b = geo_radians(b.X), lon_b = geo_radians(b.Y);
+			LD q1 = cos(lon_a - lon_b), q2 = cos(lat_a - lat_b), q3 = cos(lat_a + lat_b);
+			return (int32_t)(rrr * acos(0.5 * ((1.0 + q1) * q2 - (1.0 - q1) * q3)) + 1.0);
+		}
+
+		return (int32_t)(sqrt(dx * dx + dy * dy) + 0.5);
+	}
+
+	static void build_distances()
+	{
+		/*
+			Objective:
+				Fill the int32 distance store for integer weight types (skipped for real distances and very large instances).
+		*/
+
+		ctx().int_dist.clear();
+
+		if (ctx().weight_type == DIST_EUC || ctx().n_cities > DIST_STORE_LIMIT)
+			return;
+
+		ctx().int_dist.assign((size_t)ctx().n_cities * ctx().n_cities, 0);
+
+		for (int i = 0; i < ctx().n_cities; i++)
+			for (int j = i + 1; j < ctx().n_cities; j++)
+				ctx().int_dist[(size_t)i * ctx().n_cities + j] = ctx().int_dist[(size_t)j * ctx().n_cities + i] = tsplib_distance(ctx().city[i], ctx().city[j]);
+	}
+
+	static COST distance(const int& a, const int& b)
+	{
+		/*
+			Objective:
+				Distance between two cities given by their indices, in the cost type.
+				Integer weight types are exact, so every delta computed from them is exact too.
 		*/
 
-		path[0] = initial;
-		contain[initial] = 1;
-		
-		for (int i = 1; i < n_cities; i++)
-		{
-			int idx = utilities::random_range(0, n_cities);
-			
-			while (!reapeat && contain[idx])
-			{
-				idx = utilities::random_range(0, n_cities);
-			}
+		if (ctx().weight_type == DIST_EUC)
+			return to_cost(euclidian_distance(ctx().city[a], ctx().city[b]));
 
-			path[i] = idx;
-			contain[idx] = 1;
-		}
-		fit = Fx_fit(path, n_cities, contain);
+		if (!ctx().int_dist.empty())
+			return ctx().int_dist[(size_t)a * ctx().n_cities + b];
+
+		return (a == b ? 0 : tsplib_distance(ctx().city[a], ctx().city[b]));
 	}
 
-	static void random_path(const int& initial,const bool& reapeat, LD& fit, vector<int>& path, vector<int>& repath, vector<bool>& contain)
+	static COST swap_delta(const vector<int>& path, const int& i)
 	{
 		/*
 			Objective:
-				Method that creates a random path.
+				Cost change of swapping the cities at positions i and i + 1 (cyclic) of the path.
 			Parameters:
-				- initial: Initial index for the path.
-				- repeat: Flag indicating whether to allow repeated cities in the path.
-				- fit: Reference to the fitness value of the generated path.
-				- path: Reference to the generated path.
-				- repath: Reference to the path represented by city indices.
-				- contain: Vector indicating which cities are included in the path.
+				- path: Path represented by a vector of city indices (at least 4 cities).
+				- i: Position of the first city.
+			Returns:
+				New cost minus old cost.
 		*/
 
-		path[0] = initial;
-		repath[initial] = 0;
-		contain[initial] = 1;
-		
-		for (int i = 1; i < n_cities; i++)
-		{
-			int idx = utilities::random_range(0, n_cities);
-			
-			while (!reapeat && contain[idx])
-			{
-				idx = utilities::random_range(0, n_cities);
-			}
-
-			path[i] = idx;
-			repath[idx] = i;
-			contain[idx] = 1;
-		}
-		fit = Fx_fit(path, n_cities, contain);
+		int n = path.size();
+		int a = path[(i - 1 + n) % n], b = path[i], c = path[(i + 1) % n], d = path[(i + 2) % n];
+		return distance(a, c) + distance(b, d) - distance(a, b) - distance(c, d);
 	}
 
-	static LD euclidian_distance(const point& a, const point& b)
+	static COST exchange_delta(const vector<int>& path, int i, int j)
 	{
 		/*
 			Objective:
-				Calculate the Euclidean distance between two points.
+				Cost change of exchanging the cities at any two positions i and j of the path.
 			Parameters:
-				- a: First point.
-				- b: Second point.
+				- path: Path represented by a vector of city indices.
+				- i, j: Positions of the two cities.
 			Returns:
-				Euclidean distance between points a and b.
+				New cost minus old cost (0 with fewer than 4 cities, where every order gives the same tour).
 		*/
 
-		return sqrt((a.X - b.X) * (a.X - b.X) + (a.Y - b.Y) * (a.Y - b.Y));
+		int n = path.size();
+		if (i == j || n < 4)
+			return 0;
+		if (i > j)
+			swap(i, j);
+		if (j == i + 1)
+			return swap_delta(path, i);
+		if (i == 0 && j == n - 1)
+			return swap_delta(path, j);
+
+		int x = path[i], y = path[j];
+		int px = path[(i - 1 + n) % n], nx = path[i + 1], py = path[j - 1], ny = path[(j + 1) % n];
+		return distance(px, y) + distance(y, nx) + distance(py, x) + distance(x, ny)
+			- distance(px, x) - distance(x, nx) - distance(py, y) - distance(y, ny);
 	}
 
-	static LD Fx_fit(const vector<int>& path, const int& n, const vector<bool>& contain)
+	static COST two_opt_delta(const vector<int>& path, const int& i, const int& j)
 	{
 		/*
 			Objective:
-				Calculate the fitness value of a path based on the total distance traveled and city inclusion.
+				Cost change of reversing the segment path[i + 1..j].
 			Parameters:
 				- path: Path represented by a vector of city indices.
-				- n: Number of cities.
-				- contain: Vector indicating which cities are included in the path.
+				- i, j: Positions with i < j.
 			Returns:
-				Fitness value of the path.
+				New cost minus old cost.
 		*/
 
-		LD fit = 0;
+		int n = path.size();
+		int a = path[i], b = path[i + 1], c = path[j], d = path[(j + 1) % n];
+		return distance(a, c) + distance(b, d) - distance(a, b) - distance(c, d);
+	}
 
-		for (int i = 0; i < n - 1; i++)
-		{
-			fit += utilities::euclidian_distance(city[path[i]], city[path[i + 1]]);
-		}
+	static void apply_two_opt(vector<int>& path, const int& i, const int& j)
+	{
+		/*
+			Objective:
+				Reverse the segment path[i + 1..j].
+		*/
 
-		fit += utilities::euclidian_distance(city[path[n-1]], city[path[0]]);
+		reverse(path.begin() + i + 1, path.begin() + j + 1);
+	}
 
-		for (int i = 0; i < n; i++)
-		{
-			if (!contain[i])
-			{
+	static COST or_opt_delta(const vector<int>& path, const int& i, const int& len, const int& j)
+	{
+		/*
+			Objective:
+				Cost change of moving the segment path[i..i + len - 1] between the cities at positions j and j + 1 (cyclic).
+			Parameters:
+				- path: Path represented by a vector of city indices.
+				- i: First position of the segment (i + len <= n).
+				- len: Length of the segment.
+				- j: Position after which the segment is inserted, outside of [i - 1, i + len - 1] (cyclic).
+			Returns:
+				New cost minus old cost.
+		*/
 
-				fit = INF - fit;
-				return fit;
-			}
-		}
+		int n = path.size();
+		int prev = path[(i - 1 + n) % n], first = path[i], last = path[i + len - 1], next = path[(i + len) % n];
+		int a = path[j], b = path[(j + 1) % n];
 
-		return fit;
+		return distance(prev, next) + distance(a, first) + distance(last, b)
+			- distance(prev, first) - distance(last, next) - distance(a, b);
 	}
 
-	static LD Fx_fit(const vector<int>& path, const int& n)
+	static void apply_or_opt(vector<int>& path, const int& i, const int& len, const int& j)
 	{
 		/*
 			Objective:
-				Calculate the fitness value of a path based on the total distance traveled.
+				Move the segment path[i..i + len - 1] between the cities at positions j and j + 1.
+		*/
+
+		if (j > i)
+			rotate(path.begin() + i, path.begin() + i + len, path.begin() + j + 1);
+		else
+			rotate(path.begin() + j + 1, path.begin() + i, path.begin() + i + len);
+	}
+
+	static void double_bridge(vector<int>& path, philox& rng)
+	{
+		/*
+			Objective:
+				Double-bridge kick: cut the path into A B C D at three random points (the first city stays first) and
+				reconnect it as A C B D. A 2-opt or Or-opt local search cannot undo it in one move.
 			Parameters:
-				- path: Path represented by a vector of city indices.
-				- n: Number of cities.
-			Returns:
-				Fitness value of the path.
+				- path: Path to perturb (left unchanged with fewer than 8 cities).
+				- rng: Stream drawing the cut points.
 		*/
 
-		LD fit = 0;
+		int n = path.size();
+		if (n < 8)
+			return;
 
-		for (int i = 0; i < n - 1; i++)
+		int cut[3];
+		do
 		{
-			fit += utilities::euclidian_distance(city[path[i]], city[path[i + 1]]);
-		}
-
-		fit += utilities::euclidian_distance(city[path[n-1]], city[path[0]]);
+			for (int k = 0; k < 3; k++)
+				cut[k] = 1 + rng.bounded(n - 1);
+			sort(cut, cut + 3);
+		} while (cut[0] == cut[1] || cut[1] == cut[2]);
 
-		return fit;
+		// A = [0, cut0), B = [cut0, cut1), C = [cut1, cut2), D = [cut2, n): swapping B and C is one rotation.
+		rotate(path.begin() + cut[0], path.begin() + cut[1], path.begin() + cut[2]);
 	}
 
 	static int random_range(int start=0, int end=INT_MAX)
@@ -954,11 +2962,26 @@ public:
 				Random integer within the specified range.
 		*/
 
+		return random_range(rng(), start, end);
+	}
+
+	static int random_range(philox& rng, int start, int end)
+	{
+		/*
+			Objective:
+				Find a random integer within a specified range, drawn from a caller-owned generator.
+			Parameters:
+				- rng: Generator owned by the calling task, so parallel tasks do not share state.
+				- start: Start of the range (inclusive).
+				- end: End of the range (exclusive).
+			Returns:
+				Random integer within the specified range.
+		*/
+
 		if(start > end) 
 			swap(start, end);
-		
-		uniform_int_distribution<> dis(start, end-1);
-		return dis(gen);
+
+		return start + rng.bounded(end - start);
 	}
 
 	static LD random_range_double(int start=0, int end=1)
@@ -973,42 +2996,233 @@ public:
 				Random real number within the specified range.
 		*/
 
-		uniform_real_distribution<> dis(start, end);
-		return dis(gen);
+		return start + (end - start) * rng().real();
 	}
 
-	static void input_points(string source = INPUT_FILE)
+	static bool input_points(string source = INPUT_FILE)
 	{
 		/*
 			Objective:
 				Input points from a file.
+				The file may start with a TSPLIB EDGE_WEIGHT_TYPE name (EUC_2D, CEIL_2D, ATT or GEO) before the number
+				of cities; otherwise the "distance" parameter is used.
 			Parameters:
 				- source: Path to the input file.
+			Returns:
+				Whether the file was opened and every declared city was read (no instance is loaded otherwise).
 		*/
 
 		ifstream input(source);
-		int n;
-		input >> n;
-		n_cities = n;
+		string token;
+		int n = 0;
+		input >> token;
+		ctx().weight_type = ctx().param.distance;
+
+		// A previous instance may have been loaded into this context (batch mode reuses one per pool slot): the stores
+		// are emptied but keep their capacity.
+		ctx().city.clear();
+		ctx().xs.clear();
+		ctx().ys.clear();
+		ctx().original_id.clear();
+		ctx().alpha_near.clear();
+		ctx().lower_bound = 0;
+
+		if (!token.empty() && !isdigit(token[0]))
+		{
+			ctx().weight_type = distance_type_from(token);
+			input >> n;
+		}
+		else if (!token.empty())
+			n = stoi(token);
+
+		ctx().n_cities = n;
 
 		while (n--)
 		{
 			LD x, y;
 			input >> x >> y;
-			city.push_back(point(x, y));
+			ctx().city.push_back(point(x, y));
+			ctx().xs.push_back(x);
+			ctx().ys.push_back(y);
+		}
+
+		if (!input)
+		{
+			ctx().city.clear();
+			ctx().xs.clear();
+			ctx().ys.clear();
+			ctx().n_cities = 0;
+			ctx().int_dist.clear();
+			return false;
 		}
 
-		LD predicted;
+		LD predicted = 0;
 		input >> predicted;
-		input_predicted = predicted;
+		ctx().input_predicted = predicted;
+
+		if (ctx().param.hilbert)
+			renumber_hilbert();
+
+		build_distances();
+		return true;
+	}
+
+	static uint64_t hilbert_index(uint32_t x, uint32_t y)
+	{
+		/*
+			Objective:
+				Position of the cell (x, y) along a Hilbert curve covering a HILBERT_GRID x HILBERT_GRID grid.
+		*/
+
+		uint64_t d = 0;
+
+		for (uint32_t s = HILBERT_GRID / 2; s > 0; s /= 2)
+		{
+			uint32_t rx = (x & s) > 0;
+			uint32_t ry = (y & s) > 0;
+			d += (uint64_t)s * s * ((3 * rx) ^ ry);
+
+			if (ry == 0)
+			{
+				if (rx == 1)
+				{
+					x = HILBERT_GRID - 1 - x;
+					y = HILBERT_GRID - 1 - y;
+				}
+				swap(x, y);
+			}
+		}
+
+		return d;
+	}
+
+	static vector<int> hilbert_order()
+	{
+		/*
+			Objective:
+				Cities sorted by their position along a Hilbert curve over the bounding box of the instance.
+		*/
+
+		LD min_x = INF, min_y = INF, max_x = -INF, max_y = -INF;
+
+		for (auto& p : ctx().city)
+		{
+			min_x = min(min_x, p.X), max_x = max(max_x, p.X);
+			min_y = min(min_y, p.Y), max_y = max(max_y, p.Y);
+		}
+
+		LD span = max(max_x - min_x, max_y - min_y);
+		LD scale = (span > 0 ? (HILBERT_GRID - 1) / span : 0);
+		vector<pair<uint64_t, int>> keys(ctx().n_cities);
+
+		for (int i = 0; i < ctx().n_cities; i++)
+			keys[i] = {hilbert_index((uint32_t)((ctx().city[i].X - min_x) * scale), (uint32_t)((ctx().city[i].Y - min_y) * scale)), i};
+
+		sort(keys.begin(), keys.end());
+
+		vector<int> order(ctx().n_cities);
+		for (int i = 0; i < ctx().n_cities; i++)
+			order[i] = keys[i].second;
+
+		return order;
+	}
+
+	static void renumber_hilbert()
+	{
+		/*
+			Objective:
+				Renumber the cities along a Hilbert curve so that cities close in the plane are close in memory.
+				Every solver runs on the new numbering; original() translates paths back for the output.
+		*/
+
+		ctx().original_id = hilbert_order();
+		vector<int> new_id(ctx().n_cities);
+		vector<point> ordered;
+
+		for (int i = 0; i < ctx().n_cities; i++)
+		{
+			new_id[ctx().original_id[i]] = i;
+			ordered.push_back(ctx().city[ctx().original_id[i]]);
+			ctx().xs[i] = ordered[i].X;
+			ctx().ys[i] = ordered[i].Y;
+		}
+
+		ctx().city = ordered;
+
+		if (ctx().param.ga_p.fix_init >= 0 && ctx().param.ga_p.fix_init < ctx().n_cities)
+			ctx().param.ga_p.fix_init = new_id[ctx().param.ga_p.fix_init];
+
+		if (ctx().param.aco_p.fix_init >= 0 && ctx().param.aco_p.fix_init < ctx().n_cities)
+			ctx().param.aco_p.fix_init = new_id[ctx().param.aco_p.fix_init];
 	}
 
+	static int original(const int& id)
+	{
+		/*
+			Objective:
+				Input file index of a city, undoing a renumbering.
+		*/
+
+		return (ctx().original_id.empty() ? id : ctx().original_id[id]);
+	}
+
+
+	static void opt_2(vector<int>& best_path, COST& best_fit, bool mutation = false, vector<bool> contain = {})
+	{
+		/*
+			Objective:
+				Implement the 2-opt heuristic for optimizing a path.
+				Without mutation or contain, the best reversal is found with batched delta evaluation in O(n^2).
+
+			Parameters:
+				- best_path: Reference to the best path found.
+				- best_fit: Reference to the fitness of the best path found.
+				- mutation: Flag indicating whether to apply mutation.
+				- contain: Optional vector indicating which cities should be included in the optimization.
+		*/
+
+		if (mutation || !contain.empty())
+		{
+			opt_2_full(best_path, best_fit, mutation, contain);
+			return;
+		}
+
+		int n = ctx().n_cities;
+		if (n < 4)
+			return;
+
+		vector<int> ext = best_path;
+		vector<COST> deltas(n);
+		COST best_delta = -COST_EPS;
+		int best_i = -1, best_j = -1;
+
+		ext.push_back(best_path[0]);
 
-		static void opt_2(vector<int>& best_path, LD& best_fit, bool mutation = false, vector<bool> contain = {})
+		// Reversing path[i..j] replaces the edges (path[i - 1], path[i]) and (path[j], path[j + 1]).
+		for (int i = 0; i < n - 1; i++)
+		{
+			int a = ext[(i - 1 + n) % n], b = ext[i];
+			int count = (i == 0 ? n - 2 : n - 1 - i);
+
+			pair_deltas(a, b, &ext[i + 1], &ext[i + 2], count, -distance(a, b), deltas.data());
+
+			for (int t = 0; t < count; t++)
+				if (deltas[t] < best_delta)
+					best_delta = deltas[t], best_i = i, best_j = i + 1 + t;
+		}
+
+		if (best_i == -1)
+			return;
+
+		reverse(best_path.begin() + best_i, best_path.begin() + best_j + 1);
+		best_fit = Fx_fit(best_path, n);
+	}
+
+	static void opt_2_full(vector<int>& best_path, COST& best_fit, bool mutation = false, vector<bool> contain = {})
 		{
 			/*
 				Objective:
-					Implement the 2-opt heuristic for optimizing a path.
+					Implement the 2-opt heuristic for optimizing a path, evaluating every reversal with a full Fx_fit.
 
 				Parameters:
 					- best_path: Reference to the best path found.
@@ -1018,13 +3232,13 @@ public:
 			*/
 
 		vector<int> save_path, path_copy;
-		LD cust_copy = INF;
+		COST cust_copy = INF;
 
 		path_copy = save_path = best_path;
 
-		for (int i = 0; i < n_cities; i++)
+		for (int i = 0; i < ctx().n_cities; i++)
 		{
-			for (int j = i + 1; j < n_cities; j++)
+			for (int j = i + 1; j < ctx().n_cities; j++)
 			{
 				int idxA = i;
 				int idxB = j;
@@ -1037,9 +3251,9 @@ public:
 				}
 				
 				if (contain.empty())
-					cust_copy = utilities::Fx_fit(path_copy, n_cities);
+					cust_copy = utilities::Fx_fit(path_copy, ctx().n_cities);
 				else
-					cust_copy = utilities::Fx_fit(path_copy, n_cities, contain);
+					cust_copy = utilities::Fx_fit(path_copy, ctx().n_cities, contain);
 
 				if (!mutation && cust_copy < best_fit)
 					best_path = path_copy, best_fit = cust_copy;
@@ -1052,11 +3266,12 @@ public:
 		}   
 	}
 
-	static void opt_2s(vector<int>& best_path, LD& best_fit, bool mutation = false, vector<bool> contain = {})
+	static void opt_2s(vector<int>& best_path, COST& best_fit, bool mutation = false, vector<bool> contain = {})
 	{
 		/*
 			Objective:
 				Implement the stochastic 2-opt heuristic for optimizing a path.
+				Without contain, the reversal is scored by its delta and the path is only touched when it is applied.
 
 			Parameters:
 				- best_path: Reference to the best path found.
@@ -1065,17 +3280,30 @@ public:
 				- contain: Optional vector indicating which cities should be included in the optimization.
 		*/
 
-		vector<int> path_copy = best_path;
-		LD cust_copy = INF;
-		int idxA = utilities::random_range(1, n_cities);
-		int idxB = utilities::random_range(1, n_cities);
+		int idxA = utilities::random_range(1, ctx().n_cities);
+		int idxB = utilities::random_range(1, ctx().n_cities);
 
 		while (idxB == idxA)
-			idxB = utilities::random_range(1, n_cities);
+			idxB = utilities::random_range(1, ctx().n_cities);
 
 		if (idxA > idxB)
 			swap(idxA, idxB);
 
+		if (contain.empty())
+		{
+			COST delta = two_opt_delta(best_path, idxA - 1, idxB);
+
+			if (mutation || delta < -COST_EPS)
+			{
+				reverse(best_path.begin() + idxA, best_path.begin() + idxB + 1);
+				best_fit += delta;
+			}
+			return;
+		}
+
+		vector<int> path_copy = best_path;
+		COST cust_copy = INF;
+
 		while (idxA < idxB)
 		{
 			swap(path_copy[idxA], path_copy[idxB]);
@@ -1083,10 +3311,7 @@ public:
 			idxB--;
 		}
 		
-		if (contain.empty())
-			cust_copy = utilities::Fx_fit(path_copy, n_cities);
-		else
-			cust_copy = utilities::Fx_fit(path_copy, n_cities, contain);
+		cust_copy = utilities::Fx_fit(path_copy, ctx().n_cities, contain);
 
 		if (!mutation && cust_copy < best_fit)
 			best_path = path_copy, best_fit = cust_copy;
@@ -1095,22 +3320,33 @@ public:
 				best_path = path_copy, best_fit = cust_copy;
 	}
 
-	static void opt1(vector<int>& best_path, LD& best_fit, bool mutation = false, vector<bool> contain = {})
+	static void opt1(vector<int>& best_path, COST& best_fit, bool mutation = false, vector<bool> contain = {})
 	{
-		vector<int> path_copy = best_path;
-		LD cust_copy = INF;
-		int idxA = utilities::random_range(1, n_cities);
-		int idxB = utilities::random_range(1, n_cities);
+		int idxA = utilities::random_range(1, ctx().n_cities);
+		int idxB = utilities::random_range(1, ctx().n_cities);
 
 		while(idxA == idxB)
-			idxB = utilities::random_range(1, n_cities);
+			idxB = utilities::random_range(1, ctx().n_cities);
+
+		// Without contain, the exchange is scored by its delta and the path is only touched when it is applied.
+		if (contain.empty())
+		{
+			COST delta = exchange_delta(best_path, idxA, idxB);
+
+			if (mutation || delta < -COST_EPS)
+			{
+				swap(best_path[idxA], best_path[idxB]);
+				best_fit += delta;
+			}
+			return;
+		}
+
+		vector<int> path_copy = best_path;
+		COST cust_copy = INF;
 
 		swap(path_copy[idxA], path_copy[idxB]);
 
-		if (contain.empty())
-			cust_copy = utilities::Fx_fit(path_copy,n_cities);
-		else
-			cust_copy = utilities::Fx_fit(path_copy,n_cities, contain);
+		cust_copy = utilities::Fx_fit(path_copy,ctx().n_cities, contain);
 
 		if (!mutation && cust_copy < best_fit)
 			best_path = path_copy, best_fit = cust_copy;
@@ -1168,6 +3404,98 @@ public:
 	}
 };
 
+class rng_scope
+{
+	/*
+		Objective:
+			Installs the stream of a task as the current stream of the thread for the lifetime of the object,
+			so the utilities called by that task draw from its own sequence.
+	*/
+
+	philox own;
+	philox* previous;
+
+public:
+	rng_scope(rng_component component, uint32_t generation = 0, uint32_t individual = 0) : own(utilities::stream(component, generation, individual))
+	{
+		previous = utilities::current_rng();
+		utilities::current_rng() = &own;
+	}
+
+	~rng_scope()
+	{
+		utilities::current_rng() = previous;
+	}
+};
+
+enum monitor_action
+{
+	MONITOR_CONTINUE,
+	MONITOR_RESTART,
+	MONITOR_STOP
+};
+
+class convergence_monitor
+{
+	/*
+		Objective:
+			Convergence monitor shared by the solvers: it tracks the best cost after every iteration of the main loop
+			and reports stagnation when the best has not improved for a window of iterations, or when the population
+			diversity fell below the configured minimum. On stagnation the solver restarts (perturbing from its elite)
+			while restarts are left, and stops otherwise.
+
+		Attributes:
+			best: Best cost seen.
+			idle: Iterations since the last improvement.
+			restarts: Restarts granted so far.
+	*/
+
+	COST best = INF;
+	int idle = 0;
+	int restarts = 0;
+
+public:
+	monitor_action observe(const COST& cost, const LD& diversity = 1)
+	{
+		/*
+			Objective:
+				Record the best cost of one iteration and decide what the solver does next.
+			Parameters:
+				- cost: Best cost of the solver after the iteration.
+				- diversity: Population diversity in [0, 1] (solvers without a population leave it at 1).
+			Returns:
+				MONITOR_CONTINUE, MONITOR_RESTART or MONITOR_STOP.
+		*/
+
+		const params& p = utilities::ctx().param;
+
+		if (cost < best)
+			best = cost, idle = 0;
+		else
+			idle++;
+
+		bool stalled = p.stagnation > 0 && idle >= p.stagnation;
+		bool converged = p.min_diversity > 0 && diversity * 100 < p.min_diversity;
+
+		if (!stalled && !converged)
+			return MONITOR_CONTINUE;
+
+		idle = 0;
+		if (p.stagnation_action == "restart" && restarts < p.stagnation_restarts)
+		{
+			restarts++;
+			return MONITOR_RESTART;
+		}
+
+		return MONITOR_STOP;
+	}
+
+	int restarts_done() const
+	{
+		return restarts;
+	}
+};
+
 struct hash_pair 
 { 
 	template <class T1, class T2>
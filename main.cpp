@@ -1,14 +1,29 @@
 #include "library.hpp"
 #include "TSP.hpp"
 
-int utilities::n_cities;
-LD utilities::input_predicted;
-vector<point> utilities::city;
-params utilities::param(PARAMS_FILE);
-
-int main()
+int main(int argc, char* argv[])
 {
+	/*
+		Usage:
+			tsp                              Solve INPUT_FILE with PARAMS_FILE.
+			tsp <directory | list> [output]  Solve every .txt instance of a directory, or every path listed in a file,
+			                                 writing one record per instance to output (batch_results.csv by default).
+	*/
+
+	context instance(PARAMS_FILE);
+	context_scope scope(instance);
+	utilities::start_pool(instance.param.threads);
+	TSP a(instance);
+
+	if (argc > 1)
+	{
+		a.batch(argv[1], (argc > 2 ? argv[2] : "batch_results.csv"));
+		return 0;
+	}
+
 	utilities::input_points();
-	TSP a;
-	a.run();
+	if (instance.param.benchmark_p.active)
+		a.benchmark();
+	else
+		a.run();
 }
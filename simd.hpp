@@ -0,0 +1,226 @@
+#pragma once
+#include <math.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__)) && !defined(TSP_NO_SIMD)
+#define TSP_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+/*
+	Distance kernels over a structure-of-arrays coordinate store (xs[], ys[] in double).
+	Each kernel has a scalar version and, on x86 with GCC/Clang, AVX2 and AVX-512 versions compiled with
+	target attributes; simd_kernels picks the widest one the CPU supports once, at the first call.
+*/
+
+enum simd_level
+{
+	SIMD_SCALAR,
+	SIMD_AVX2,
+	SIMD_AVX512
+};
+
+static double edge_length(const double* xs, const double* ys, int a, int b)
+{
+	double dx = xs[a] - xs[b], dy = ys[a] - ys[b];
+	return sqrt(dx * dx + dy * dy);
+}
+
+static double tour_length_scalar(const double* xs, const double* ys, const int* path, int n)
+{
+	/*
+		Objective:
+			Length of the closed tour path[0..n - 1].
+	*/
+
+	double sum = 0;
+
+	for (int i = 0; i + 1 < n; i++)
+		sum += edge_length(xs, ys, path[i], path[i + 1]);
+
+	return sum + edge_length(xs, ys, path[n - 1], path[0]);
+}
+
+static void pair_deltas_scalar(const double* xs, const double* ys, int a, int b, const int* c, const int* d, int k, double base, double* out)
+{
+	/*
+		Objective:
+			For every candidate t < k, out[t] = base + |a - c[t]| + |b - d[t]| - |c[t] - d[t]|.
+			With base = -|a - b| this is the delta of the 2-opt move replacing (a, b), (c, d) by (a, c), (b, d);
+			with a = b it is the insertion part of an Or-opt move of a between c and d.
+	*/
+
+	for (int t = 0; t < k; t++)
+		out[t] = base + edge_length(xs, ys, a, c[t]) + edge_length(xs, ys, b, d[t]) - edge_length(xs, ys, c[t], d[t]);
+}
+
+#ifdef TSP_X86_SIMD
+
+/*
+	The gathers, the square root and the reduction below use the masked forms of the intrinsics with a zeroed
+	source and a full mask: the unmasked forms pass an undefined source operand, which GCC reports as uninitialized.
+*/
+
+__attribute__((target("avx2,fma")))
+static __m256d gather_avx2(const double* base, __m128i index)
+{
+	return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), base, index, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);
+}
+
+__attribute__((target("avx2,fma")))
+static __m256d distance_avx2(__m256d x1, __m256d y1, __m256d x2, __m256d y2)
+{
+	__m256d dx = _mm256_sub_pd(x1, x2), dy = _mm256_sub_pd(y1, y2);
+	return _mm256_sqrt_pd(_mm256_fmadd_pd(dx, dx, _mm256_mul_pd(dy, dy)));
+}
+
+__attribute__((target("avx2,fma")))
+static double tour_length_avx2(const double* xs, const double* ys, const int* path, int n)
+{
+	__m256d acc = _mm256_setzero_pd();
+	int i = 0;
+
+	for (; i + 4 < n; i += 4)
+	{
+		__m128i from = _mm_loadu_si128((const __m128i*)(path + i));
+		__m128i to = _mm_loadu_si128((const __m128i*)(path + i + 1));
+		acc = _mm256_add_pd(acc, distance_avx2(gather_avx2(xs, from), gather_avx2(ys, from),
+			gather_avx2(xs, to), gather_avx2(ys, to)));
+	}
+
+	double lanes[4];
+	_mm256_storeu_pd(lanes, acc);
+	double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+
+	for (; i + 1 < n; i++)
+		sum += edge_length(xs, ys, path[i], path[i + 1]);
+
+	return sum + edge_length(xs, ys, path[n - 1], path[0]);
+}
+
+__attribute__((target("avx2,fma")))
+static void pair_deltas_avx2(const double* xs, const double* ys, int a, int b, const int* c, const int* d, int k, double base, double* out)
+{
+	__m256d ax = _mm256_set1_pd(xs[a]), ay = _mm256_set1_pd(ys[a]);
+	__m256d bx = _mm256_set1_pd(xs[b]), by = _mm256_set1_pd(ys[b]);
+	__m256d vbase = _mm256_set1_pd(base);
+	int t = 0;
+
+	for (; t + 4 <= k; t += 4)
+	{
+		__m128i ci = _mm_loadu_si128((const __m128i*)(c + t));
+		__m128i di = _mm_loadu_si128((const __m128i*)(d + t));
+		__m256d cx = gather_avx2(xs, ci), cy = gather_avx2(ys, ci);
+		__m256d dx = gather_avx2(xs, di), dy = gather_avx2(ys, di);
+		__m256d delta = _mm256_add_pd(vbase, _mm256_add_pd(distance_avx2(ax, ay, cx, cy), distance_avx2(bx, by, dx, dy)));
+		_mm256_storeu_pd(out + t, _mm256_sub_pd(delta, distance_avx2(cx, cy, dx, dy)));
+	}
+
+	pair_deltas_scalar(xs, ys, a, b, c + t, d + t, k - t, base, out + t);
+}
+
+__attribute__((target("avx512f")))
+static __m512d gather_avx512(const double* base, __m256i index)
+{
+	return _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, index, base, 8);
+}
+
+__attribute__((target("avx512f")))
+static __m512d distance_avx512(__m512d x1, __m512d y1, __m512d x2, __m512d y2)
+{
+	__m512d dx = _mm512_sub_pd(x1, x2), dy = _mm512_sub_pd(y1, y2);
+	return _mm512_mask_sqrt_pd(_mm512_setzero_pd(), 0xFF, _mm512_fmadd_pd(dx, dx, _mm512_mul_pd(dy, dy)));
+}
+
+__attribute__((target("avx512f")))
+static double tour_length_avx512(const double* xs, const double* ys, const int* path, int n)
+{
+	__m512d acc = _mm512_setzero_pd();
+	int i = 0;
+
+	for (; i + 8 < n; i += 8)
+	{
+		__m256i from = _mm256_loadu_si256((const __m256i*)(path + i));
+		__m256i to = _mm256_loadu_si256((const __m256i*)(path + i + 1));
+		acc = _mm512_add_pd(acc, distance_avx512(gather_avx512(xs, from), gather_avx512(ys, from),
+			gather_avx512(xs, to), gather_avx512(ys, to)));
+	}
+
+	double lanes[8];
+	_mm512_storeu_pd(lanes, acc);
+	double sum = ((lanes[0] + lanes[4]) + (lanes[2] + lanes[6])) + ((lanes[1] + lanes[5]) + (lanes[3] + lanes[7]));
+
+	for (; i + 1 < n; i++)
+		sum += edge_length(xs, ys, path[i], path[i + 1]);
+
+	return sum + edge_length(xs, ys, path[n - 1], path[0]);
+}
+
+__attribute__((target("avx512f")))
+static void pair_deltas_avx512(const double* xs, const double* ys, int a, int b, const int* c, const int* d, int k, double base, double* out)
+{
+	__m512d ax = _mm512_set1_pd(xs[a]), ay = _mm512_set1_pd(ys[a]);
+	__m512d bx = _mm512_set1_pd(xs[b]), by = _mm512_set1_pd(ys[b]);
+	__m512d vbase = _mm512_set1_pd(base);
+	int t = 0;
+
+	for (; t + 8 <= k; t += 8)
+	{
+		__m256i ci = _mm256_loadu_si256((const __m256i*)(c + t));
+		__m256i di = _mm256_loadu_si256((const __m256i*)(d + t));
+		__m512d cx = gather_avx512(xs, ci), cy = gather_avx512(ys, ci);
+		__m512d dx = gather_avx512(xs, di), dy = gather_avx512(ys, di);
+		__m512d delta = _mm512_add_pd(vbase, _mm512_add_pd(distance_avx512(ax, ay, cx, cy), distance_avx512(bx, by, dx, dy)));
+		_mm512_storeu_pd(out + t, _mm512_sub_pd(delta, distance_avx512(cx, cy, dx, dy)));
+	}
+
+	pair_deltas_scalar(xs, ys, a, b, c + t, d + t, k - t, base, out + t);
+}
+
+#endif
+
+struct simd_kernels
+{
+	/*
+		Objective:
+			Kernels selected for the running CPU.
+
+		Attributes:
+			level: Instruction set in use.
+			tour_length: Length of a closed tour.
+			pair_deltas: Batched 2-opt/Or-opt deltas of one city against a list of candidate edges.
+	*/
+
+	simd_level level;
+	double (*tour_length)(const double*, const double*, const int*, int);
+	void (*pair_deltas)(const double*, const double*, int, int, const int*, const int*, int, double, double*);
+
+	simd_kernels()
+	{
+		level = SIMD_SCALAR;
+		tour_length = tour_length_scalar;
+		pair_deltas = pair_deltas_scalar;
+
+#ifdef TSP_X86_SIMD
+		__builtin_cpu_init();
+
+		if (__builtin_cpu_supports("avx512f"))
+		{
+			level = SIMD_AVX512;
+			tour_length = tour_length_avx512;
+			pair_deltas = pair_deltas_avx512;
+		}
+		else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		{
+			level = SIMD_AVX2;
+			tour_length = tour_length_avx2;
+			pair_deltas = pair_deltas_avx2;
+		}
+#endif
+	}
+
+	static const simd_kernels& get()
+	{
+		static const simd_kernels selected;
+		return selected;
+	}
+};
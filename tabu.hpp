@@ -0,0 +1,329 @@
+#pragma once
+#include "library.hpp"
+
+class tabu
+{
+    /*
+        Objective:
+            Tabu search over the 2-opt and swap neighborhoods restricted to candidate lists. Every iteration applies the
+            best admissible move, even a worsening one, unless the move gives a new best tour (aspiration):
+            - a candidate edge removed by a move may not be added back for tenure iterations (edges outside the candidate
+              lists carry no attribute);
+            - a city moved by a swap may not be swapped again for tenure iterations.
+            Every attribute has its own expiry iteration in a flat array. A 2-opt move is tabu when the candidate edge it
+            adds is tabu in either direction, which the slot and its reverse slot answer in O(1): undoing a move means
+            adding back one of its removed edges as a candidate edge, so reversals stay forbidden.
+            When every move is tabu, the current tour is kicked by a double bridge. No randomness is used outside kicks
+            and restarts, so runs are deterministic.
+
+        Attributes:
+            ctx: Context of the solve.
+            n: Number of cities.
+            k: Candidates per city.
+            tenure: Iterations during which a removed edge stays tabu.
+            tour, pos: Current tour and the position of every city in it.
+            neighbors: Flat candidate lists (alpha-nearest when the lower bound computed them, nearest otherwise).
+            edge_until: For slot c * k + s, the iteration until which the edge from c to its s-th candidate is tabu.
+            rev: For slot c * k + s, the slot of the same edge in the candidate list of its other endpoint, or -1.
+            city_until: For every city, the iteration until which it may not be swapped.
+            cs, ds, ss, deltas: Scratch buffers of the batched move evaluation.
+            best_solution: Best tour found.
+            best_cost: Cost of the best tour found.
+    */
+
+    context& ctx;
+    int n;
+    int k;
+    int tenure;
+    vector<int> tour, pos;
+    vector<int> neighbors;
+    vector<int> edge_until, rev, city_until;
+    vector<int> cs, ds, ss;
+    vector<COST> deltas;
+
+    int succ(const int& c)
+    {
+        return tour[pos[c] + 1 == n ? 0 : pos[c] + 1];
+    }
+
+    int pred(const int& c)
+    {
+        return tour[pos[c] == 0 ? n - 1 : pos[c] - 1];
+    }
+
+    void load(const vector<int>& path)
+    {
+        tour = path;
+        for (int i = 0; i < n; i++)
+            pos[tour[i]] = i;
+    }
+
+    int slot(const int& u, const int& v)
+    {
+        /*
+            Objective:
+                Attribute slot of the edge from u to v, or -1 when v is not a candidate of u.
+        */
+
+        for (int t = 0; t < k; t++)
+            if (neighbors[u * k + t] == v)
+                return u * k + t;
+        return -1;
+    }
+
+    bool is_tabu(const int& s, const int& it)
+    {
+        /*
+            Objective:
+                Whether the candidate edge in slot s is tabu in either direction.
+        */
+
+        return edge_until[s] > it || (rev[s] != -1 && edge_until[rev[s]] > it);
+    }
+
+    void forbid(const int& u, const int& v, const int& it)
+    {
+        /*
+            Objective:
+                Make the removed edge (u, v) tabu in the candidate lists of both endpoints that contain it.
+        */
+
+        int su = slot(u, v), sv = slot(v, u);
+        if (su != -1)
+            edge_until[su] = it + tenure;
+        if (sv != -1)
+            edge_until[sv] = it + tenure;
+    }
+
+    void reverse_path(int from, int to)
+    {
+        /*
+            Objective:
+                Reverse the cities at positions from..to (cyclic), or the shorter complement, which gives the same tour.
+        */
+
+        int len = (to - from + n) % n + 1;
+        if (2 * len > n)
+        {
+            int start = (to + 1) % n;
+            to = (from - 1 + n) % n;
+            from = start;
+            len = n - len;
+        }
+
+        for (int s = 0; s < len / 2; s++)
+        {
+            swap(tour[from], tour[to]);
+            pos[tour[from]] = from;
+            pos[tour[to]] = to;
+            from = (from + 1 == n ? 0 : from + 1);
+            to = (to == 0 ? n - 1 : to - 1);
+        }
+    }
+
+    COST swap_delta(const int& x, const int& y)
+    {
+        /*
+            Objective:
+                Cost change of exchanging the non-adjacent cities x and y.
+        */
+
+        int px = pred(x), nx = succ(x), py = pred(y), ny = succ(y);
+
+        return utilities::distance(px, y) + utilities::distance(y, nx) + utilities::distance(py, x) + utilities::distance(x, ny)
+            - utilities::distance(px, x) - utilities::distance(x, nx) - utilities::distance(py, y) - utilities::distance(y, ny);
+    }
+
+    bool step(const int& it, COST& current, const COST& best)
+    {
+        /*
+            Objective:
+                Apply the best admissible move of the neighborhood: 2-opt moves adding an edge (a, c) and swaps making
+                c the successor of a, for every city a and candidate c. A tabu move is admissible only when it improves
+                on the best tour.
+
+            Parameters:
+                - it: Current iteration.
+                - current: Cost of the current tour, updated by the move.
+                - best: Cost of the best tour.
+
+            Returns:
+                Whether a move was admissible.
+        */
+
+        int move = -1, move_a = -1, move_c = -1;
+        COST move_delta = INF;
+
+        for (int a = 0; a < n; a++)
+        {
+            int b = succ(a), m = 0;
+
+            for (int t = 0; t < k; t++)
+            {
+                int c = neighbors[a * k + t], d = succ(c);
+                if (c == b || d == a)
+                    continue;
+                cs[m] = c, ds[m] = d, ss[m] = a * k + t, m++;
+            }
+
+            utilities::pair_deltas(a, b, cs.data(), ds.data(), m, -utilities::distance(a, b), deltas.data());
+
+            for (int t = 0; t < m; t++)
+            {
+                if (deltas[t] >= move_delta)
+                    continue;
+                if (is_tabu(ss[t], it) && current + deltas[t] >= best - COST_EPS)
+                    continue;
+                move = 0, move_a = a, move_c = cs[t], move_delta = deltas[t];
+            }
+
+            for (int t = 0; t < k; t++)
+            {
+                int c = neighbors[a * k + t];
+                if (c == b || c == a || c == succ(b) || b == succ(c))
+                    continue;
+
+                COST delta = swap_delta(b, c);
+                if (delta >= move_delta)
+                    continue;
+
+                bool forbidden = city_until[b] > it || city_until[c] > it;
+                if (forbidden && current + delta >= best - COST_EPS)
+                    continue;
+                move = 1, move_a = a, move_c = c, move_delta = delta;
+            }
+        }
+
+        if (move == -1)
+            return false;
+
+        int a = move_a, b = succ(a), c = move_c;
+
+        if (move == 0)
+        {
+            int d = succ(c);
+            forbid(a, b, it);
+            forbid(c, d, it);
+            reverse_path(pos[b], pos[c]);
+        }
+        else
+        {
+            int pc = pred(c), nc = succ(c), nb = succ(b);
+            forbid(a, b, it), forbid(b, nb, it);
+            forbid(pc, c, it), forbid(c, nc, it);
+            city_until[b] = city_until[c] = it + tenure;
+            swap(tour[pos[b]], tour[pos[c]]);
+            swap(pos[b], pos[c]);
+        }
+
+        current += move_delta;
+        return true;
+    }
+
+public:
+    vector<int> best_solution;
+    COST best_cost;
+
+    tabu(context& instance, vector<int> s_initial, COST s_cost_initial) : ctx(instance)
+    {
+        /*
+            Objective:
+                Constructor for initializing the tabu search.
+
+            Parameters:
+                instance: Context of the solve.
+                s_initial: Initial solution.
+                s_cost_initial: Initial solution cost.
+        */
+
+        n = ctx.n_cities;
+        k = max(0, min(ctx.param.tabu_p.candidates, n - 1));
+        tenure = ctx.param.tabu_p.tenure;
+        best_solution = s_initial;
+        best_cost = s_cost_initial;
+    }
+
+    COST solution()
+    {
+        /*
+            Objective:
+                Execute the tabu search.
+
+            Returns:
+                Best cost found by the algorithm.
+        */
+
+        context_scope scope(ctx);
+        convergence_monitor monitor;
+
+        if (n < 8)
+            return best_cost;
+
+        neighbors = utilities::candidate_lists(k);
+        pos.assign(n, 0);
+        edge_until.assign(n * k, 0);
+        city_until.assign(n, 0);
+        cs.assign(k, 0), ds.assign(k, 0), ss.assign(k, 0), deltas.assign(k, 0);
+
+        rev.assign(n * k, -1);
+        for (int s = 0; s < n * k; s++)
+            rev[s] = slot(neighbors[s], s / k);
+        load(best_solution);
+
+        COST current = best_cost;
+
+        for (int it = 0; it < ctx.param.tabu_p.iterations && !utilities::should_stop(best_cost); it++)
+        {
+            // Every move is tabu: diversify from a double-bridge kick of the current tour instead of idling.
+            if (!step(it, current, best_cost))
+            {
+                philox kick = utilities::stream(RNG_TABU, it, 1);
+                vector<int> path = tour;
+                utilities::double_bridge(path, kick);
+                load(path);
+                current = utilities::Fx_fit(tour, n);
+            }
+
+            if (current < best_cost - COST_EPS)
+            {
+                // The running cost only guides the search; the best tour is re-measured exactly.
+                current = utilities::Fx_fit(tour, n);
+                if (current < best_cost)
+                {
+                    best_solution = tour;
+                    best_cost = utilities::Fx_fit(tour, n);
+                }
+            }
+
+            // Portfolio checkpoint: continue from the incumbent when another solver found a better tour.
+            if (utilities::share(best_solution, best_cost))
+            {
+                load(best_solution);
+                current = best_cost;
+            }
+
+            // Stagnation: continue from the best tour kicked by a double bridge, or stop.
+            monitor_action action = monitor.observe(best_cost);
+            if (action == MONITOR_STOP)
+                break;
+            if (action == MONITOR_RESTART)
+            {
+                philox kick = utilities::stream(RNG_TABU, it);
+                vector<int> path = best_solution;
+                utilities::double_bridge(path, kick);
+                load(path);
+                current = utilities::Fx_fit(tour, n);
+            }
+
+            if (ctx.param.tabu_p.verbose)
+            {
+                cout << endl << it << ": " << best_cost << endl;
+                if (ctx.lower_bound > 0)
+                    cout << "Gap: " << utilities::gap(best_cost) << "%" << endl;
+            }
+        }
+
+        ctx.elites.offer(best_solution, best_cost);
+        return best_cost;
+    }
+};